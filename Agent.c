@@ -17,22 +17,8 @@
 //    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
 //    This uses the bfs algorithm to find the shortest path that takes the least
 //    number of turns to the thief's location given by the informant.
-//  - ltpGetMoves: The following code was adapted from the comp2521 2024T3 Graph
-//    Traversal slides.
-//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
-//    This gets the moves for the bfs until the queue that holds all the cities
-//    that still needs to be accounted for is empty
-//  - fillQueue: The following code was adapted from the comp2521 2024T3 Graph 
-//    Traversal slides.
-//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
-//    Enqueues all the non-visited cities that is adjacent to the current city 
-//    into the queue.
-//  - Queue.h: The following interface was taken from the comp2521 2024T3 lab4 
-//    resources.
-//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/labs/week04/files/Queue.h
-//  - Queue.c: The following interface was taken from the comp2521 2024T3 lab4 
-//    resources.
-//    Link :https://cgi.cse.unsw.edu.au/~cs2521/24T3/labs/week04/files/Queue.c
+
+#define _POSIX_C_SOURCE 200809L // for rand_r
 
 #include <assert.h>
 #include <stdbool.h>
@@ -42,22 +28,57 @@
 #include <limits.h>
 
 #include "Agent.h"
+#include "Allocator.h"
+#include "Fields.h"
+#include "HubTree.h"
+#include "Landmarks.h"
+#include "LeastTurns.h"
+#include "LtpTable.h"
 #include "Map.h"
-#include "Queue.h"
+#include "Team.h"
+#include "Visits.h"
+
+// Cities with at least this many roads get a hub tree for the
+// CHEAPEST_LEAST_VISITED strategy
+#define HUB_DEGREE 32
 
 // This struct stores information about an individual agent and can be
 // used to store information that the agent needs to remember.
 struct agent
 {
+    Allocator allocator; // for everything the agent keeps between moves
     char *name;
     int startLocation;
     int location;
     int maxStamina; // max stamina
     int stamina;    // current stamina
     int strategy;
+    int engine;
     Map map;
-
+    unsigned long mapVersion; // the version of the map the plans are for
+    bool hasSeed;
+    unsigned int seed; // state of the agent's own random number generator
+
+    // The agent's own visit counts, which are only made once it has been
+    // somewhere other than where it started, or the counts it shares with
+    // its team (in which case it has no counts of its own). A visit counted
+    // while working out a move is held in plannedVisit (or -1) until the
+    // move is made if the counts are shared, since the rest of the team may
+    // be working out their moves at the same time.
     int *citiesVisitedCount;
+    Visits visits;
+    int plannedVisit;
+
+    // For CHEAPEST_LEAST_VISITED: a tree over the roads of every hub city the
+    // agent has been in (indexed by city, and NULL until then), and the
+    // cities whose visits have been counted since some tree was last
+    // brought up to date. A tree catches up with the visits in the log when
+    // the agent is next in its city.
+    HubTree *hubTrees;
+    int *hubTreeSynced; // the number of the log's visits each tree has
+    unsigned long hubTreesVersion;
+    int *visitLog;
+    int visitLogLength;
 
     struct move *dfsPath;
     int dfsPathSize;
@@ -68,51 +89,102 @@ struct agent
     int ltpPathNumElements;
     int ltpIndex;
     int thiefLocation;
-};
 
-// This struct is used for simulating the path that the agent takes with the
-// expected remaining stamina when the agent is in the city of an informant.
-struct costedMove
-{
-    struct move m;
-    int remainingStamina;
-    int numMovesTaken;
+    LtpTable ltpTable; // precomputed paths for tip-offs, or NULL
+    Landmarks landmarks; // for goal-directed searches, or NULL
+    Pool searchPool; // for parallel least turns searches, or NULL
+    Team team; // plans the moves of a COORDINATED agent, or NULL
+
+    // For GETAWAY_SEEKING: the goal city. For GETAWAY_SEEKING and
+    // INFORMANT_SEEKING: the fields that give the next road towards the goal
+    // or the nearest informant from every city, shared with other agents or
+    // made by the agent on its first move (in which case ownsFields is true).
+    int goal;
+    Fields fields;
+    bool ownsFields;
+
+    // With a planning budget, a tip-off starts a search from the thief's
+    // location which is carried on a few cities at a time on every move.
+    // The agent follows the search's paths towards the thief as soon as it
+    // has one from the agent's city, and they get better as it goes on.
+    long planningBudget; // cities per move, or 0 for no limit
+    PartialSearch plan; // NULL once the search has finished
+    struct costedMove *planField; // NULL if the agent has no plan
+    int planCity;
+    unsigned long planVersion;
+    long numBudgetHits;
 };
 
 static void printNullError(void);
 
+static void repairPlans(Agent agent, Map m);
+static bool repairPath(Map m, int city, struct move path[], int first,
+                       int last, int step);
+
 static struct move chooseRandomMove(Agent agent, Map m);
+static int agentRand(Agent agent);
 static int filterRoads(Agent agent, struct road roads[], int numRoads,
                        struct road legalRoads[]);
 
 static struct move chooseClvMove(Agent agent, Map m);
-static struct move setClvMove(Agent agent, struct road *legalRoads,
+static struct move referenceChooseClvMove(Agent agent, Map m);
+static struct move setClvMove(Agent agent, const struct road *legalRoads,
                               struct move clvMove, int *index);
 static struct road *createRoads(Map m);
 static struct move nextClvMove(Agent agent, int numLegalRoads,
-                               struct road *legalRoads);
+                               const struct road *legalRoads);
+static struct move hubClvMove(Agent agent, Map m);
+static void countVisit(Agent agent, int city);
+static void countPlannedVisit(Agent agent, int city);
+static int visitCount(Agent agent, int city);
+static void makeVisitCounts(Agent agent);
+static void syncHubTree(Agent agent, int city);
+static void freeHubTrees(Agent agent);
 
 static struct move chooseDfsMove(Agent agent, Map m);
 static void dfs(Agent agent, Map m, int city);
 static void dfsRec(Map m, int city, bool *visited, Agent agent);
-static struct move *reallocatePathCheck(struct move **path, int numElements,
+static struct move *reallocatePathCheck(Allocator allocator,
+                                        struct move **path, int numElements,
                                         int *pathSize);
 
+static struct move chooseGoalMove(Agent agent, Map m);
+static struct move referenceChooseGoalMove(Agent agent, Map m);
+static void searchFromGoal(Agent agent, Map m, struct costedMove *field);
+static struct move followField(Agent agent, const struct costedMove *field);
+
+static void startPlan(Agent agent, Map m, int thiefLocation);
+static bool followPlan(Agent agent, Map m, struct move *move);
+static void stopPlan(Agent agent);
+
 static void leastTurnsPath(Agent agent, Map m, int city, int stamina);
-static void ltpGetMoves(Queue q, struct costedMove *predecessor, int stamina,
-                        Map m, Agent agent);
-static int compare(const void *a, const void *b);
-static void fillQueue(struct road *roads, int roadSize, Queue q, 
-                      int currentCity, struct costedMove *predecessor,
-                      int thiefLocation, int stamina);
-static bool pathNeedsUpdating(struct road *roads, int currentCity,
-                              struct costedMove *predecessor, int index);
+static void referenceLeastTurnsPath(Agent agent, Map m, int city,
+                                    int stamina);
+static void referenceTipOffPath(Agent agent, Map m, int thiefLocation);
 static void copyPathIntoLtpPath(Agent agent, struct costedMove *predecessor);
+static void copyReversePathIntoLtpPath(Agent agent,
+                                       struct costedMove *successor);
+static void copyTablePathIntoLtpPath(Agent agent, LtpTable table,
+                                     int thiefLocation);
+static void searchFromThief(Agent agent, Map m, int thiefLocation,
+                            struct costedMove *successor);
+static void forwardTipOffPath(Agent agent, Map m, int thiefLocation);
+static LtpTable findLtpTable(Agent agents[], int numAgents, Map m);
+static int compareMaxStamina(const void *a, const void *b);
 
 /**
- * Creates a new agent
+ * Creates a new agent whose memory comes from malloc
  */
 Agent AgentNew(int start, int stamina, int strategy, Map m, char *name)
+{
+    return AgentNewWithAllocator(start, stamina, strategy, m, name, NULL);
+}
+
+/**
+ * Creates a new agent
+ */
+Agent AgentNewWithAllocator(int start, int stamina, int strategy, Map m,
+                            char *name, Allocator allocator)
 {
     if (start >= MapNumCities(m))
     {
@@ -120,29 +192,37 @@ Agent AgentNew(int start, int stamina, int strategy, Map m, char *name)
         exit(EXIT_FAILURE);
     }
 
-    Agent agent = malloc(sizeof(struct agent));
+    Agent agent = AllocatorMalloc(allocator, sizeof(struct agent));
     if (agent == NULL)
     {
         fprintf(stderr, "error: out of memory\n");
         exit(EXIT_FAILURE);
     }
 
+    agent->allocator = allocator;
     agent->startLocation = start;
     agent->location = start;
     agent->maxStamina = stamina;
     agent->stamina = stamina;
     agent->strategy = strategy;
+    agent->engine = ENGINE_OPTIMIZED;
     agent->map = m;
-    agent->name = strdup(name);
-
-    agent->citiesVisitedCount = calloc(MapNumCities(m), sizeof(int));
-    if (agent->citiesVisitedCount == NULL)
-    {
-        printNullError();
-    }
-    agent->citiesVisitedCount[start]++;
-
-    agent->dfsPath = malloc(MapNumCities(m) * sizeof(struct move));
+    agent->mapVersion = MapVersion(m);
+    agent->hasSeed = false;
+    agent->seed = 0;
+    agent->name = AllocatorStrdup(allocator, name);
+
+    agent->citiesVisitedCount = NULL;
+    agent->visits = NULL;
+    agent->plannedVisit = -1;
+    agent->hubTrees = NULL;
+    agent->hubTreeSynced = NULL;
+    agent->hubTreesVersion = 0;
+    agent->visitLog = NULL;
+    agent->visitLogLength = 0;
+
+    agent->dfsPath = AllocatorMalloc(allocator,
+                                     MapNumCities(m) * sizeof(struct move));
     if (agent->dfsPath == NULL)
     {
         printNullError();
@@ -151,7 +231,8 @@ Agent AgentNew(int start, int stamina, int strategy, Map m, char *name)
     agent->dfsPathNumElements = 0;
     agent->dfsIndex = 0;
 
-    agent->ltpPath = malloc(MapNumCities(m) * sizeof(struct move));
+    agent->ltpPath = AllocatorMalloc(allocator,
+                                     MapNumCities(m) * sizeof(struct move));
     if (agent->ltpPath == NULL)
     {
         printNullError();
@@ -160,6 +241,20 @@ Agent AgentNew(int start, int stamina, int strategy, Map m, char *name)
     agent->ltpIndex = 0;
     agent->thiefLocation = -1;
 
+    agent->ltpTable = NULL;
+    agent->landmarks = NULL;
+    agent->searchPool = NULL;
+    agent->team = NULL;
+    agent->goal = -1;
+    agent->fields = NULL;
+    agent->ownsFields = false;
+    agent->planningBudget = 0;
+    agent->plan = NULL;
+    agent->planField = NULL;
+    agent->planCity = -1;
+    agent->planVersion = 0;
+    agent->numBudgetHits = 0;
+
     return agent;
 }
 
@@ -180,11 +275,17 @@ static void printNullError(void)
  */
 void AgentFree(Agent agent)
 {
-    free(agent->citiesVisitedCount);
-    free(agent->dfsPath);
-    free(agent->ltpPath);
-    free(agent->name);
-    free(agent);
+    AllocatorRelease(agent->allocator, agent->citiesVisitedCount);
+    freeHubTrees(agent);
+    AllocatorRelease(agent->allocator, agent->dfsPath);
+    AllocatorRelease(agent->allocator, agent->ltpPath);
+    if (agent->ownsFields)
+    {
+        FieldsFree(agent->fields);
+    }
+    stopPlan(agent);
+    AllocatorRelease(agent->allocator, agent->name);
+    AllocatorRelease(agent->allocator, agent);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -215,6 +316,25 @@ int AgentStamina(Agent agent)
     return agent->stamina;
 }
 
+/**
+ * Gets the maximum stamina of the agent
+ */
+int AgentMaxStamina(Agent agent)
+{
+    return agent->maxStamina;
+}
+
+/**
+ * An agent chases the thief from the move after a tip-off until it reaches
+ * the end of its path, or while it has a search under way
+ */
+bool AgentIsChasing(Agent agent)
+{
+    return agent->thiefLocation != -1 ||
+           (agent->ltpIndex >= 0 && agent->ltpPathNumElements != 0) ||
+           agent->planField != NULL;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Making moves
 
@@ -224,10 +344,29 @@ int AgentStamina(Agent agent)
  */
 struct move AgentGetNextMove(Agent agent, Map m)
 {
+    // When roads have changed since the agent's plans were made.
+    if (agent->mapVersion != MapVersion(m))
+    {
+        repairPlans(agent, m);
+    }
+
     // When the agent is at a city with an informant.
     if (agent->thiefLocation != -1)
     {
-        leastTurnsPath(agent, m, agent->location, agent->maxStamina);
+        if (agent->engine == ENGINE_REFERENCE)
+        {
+            referenceLeastTurnsPath(agent, m, agent->location,
+                                    agent->maxStamina);
+        }
+        else if (agent->planningBudget > 0)
+        {
+            startPlan(agent, m, agent->thiefLocation);
+        }
+        else
+        {
+            stopPlan(agent);
+            leastTurnsPath(agent, m, agent->location, agent->maxStamina);
+        }
         // sets the dfsIndex to the the end of the array so it sets its moves
         // based on the new dfs created when it returns to the dfs strategy
         agent->dfsIndex = agent->dfsPathNumElements;
@@ -242,10 +381,16 @@ struct move AgentGetNextMove(Agent agent, Map m)
         {
             return (struct move){agent->location, 0};
         }
-        agent->citiesVisitedCount[agent->ltpPath[agent->ltpIndex].to]++;
+        countPlannedVisit(agent, agent->ltpPath[agent->ltpIndex].to);
         return agent->ltpPath[agent->ltpIndex--];
     }
 
+    struct move planMove;
+    if (agent->planField != NULL && followPlan(agent, m, &planMove))
+    {
+        return planMove;
+    }
+
     if (agent->strategy == STATIONARY)
     {
         return (struct move){agent->location, 0};
@@ -262,6 +407,16 @@ struct move AgentGetNextMove(Agent agent, Map m)
     {
         return chooseDfsMove(agent, m);
     }
+    else if (agent->strategy == GETAWAY_SEEKING ||
+             agent->strategy == INFORMANT_SEEKING)
+    {
+        return chooseGoalMove(agent, m);
+    }
+    else if (agent->strategy == COORDINATED)
+    {
+        return agent->team != NULL ? TeamNextMove(agent->team, agent)
+                                   : chooseClvMove(agent, m);
+    }
     else
     {
         printf("error: strategy not implemented yet\n");
@@ -269,6 +424,55 @@ struct move AgentGetNextMove(Agent agent, Map m)
     }
 }
 
+/**
+ * Brings the agent's remaining ltpPath and dfsPath moves up to date with the
+ * map's roads. Moves along roads whose length has changed are given the new
+ * stamina cost. If a road on the ltpPath has been removed, the path is
+ * planned again to the same city, and if a road on the dfsPath has been
+ * removed, a new dfs is mapped out from the agent's location.
+ */
+static void repairPlans(Agent agent, Map m)
+{
+    agent->mapVersion = MapVersion(m);
+
+    // the ltpPath is followed from ltpIndex down to 0
+    if (agent->ltpIndex >= 0 && agent->ltpPathNumElements != 0 &&
+        !repairPath(m, agent->location, agent->ltpPath, agent->ltpIndex, -1,
+                    -1) && agent->thiefLocation == -1)
+    {
+        agent->thiefLocation = agent->ltpPath[0].to;
+    }
+
+    // the dfsPath is followed from dfsIndex up to dfsPathNumElements - 1
+    if (!repairPath(m, agent->location, agent->dfsPath, agent->dfsIndex,
+                    agent->dfsPathNumElements, 1))
+    {
+        agent->dfsIndex = agent->dfsPathNumElements;
+    }
+}
+
+/**
+ * Updates the stamina costs of the path's moves from index `first` up to
+ * (but not including) index `last`, moving `step` indexes at a time, where
+ * the first move starts at the given city. Returns false if any move is
+ * along a road that no longer exists.
+ */
+static bool repairPath(Map m, int city, struct move path[], int first,
+                       int last, int step)
+{
+    for (int i = first; i != last; i += step)
+    {
+        int length = MapContainsRoad(m, city, path[i].to);
+        if (length == 0)
+        {
+            return false;
+        }
+        path[i].staminaCost = length;
+        city = path[i].to;
+    }
+    return true;
+}
+
 /**
  * returns the next move based on a random road which the current city that the
  * agent is in has
@@ -288,7 +492,7 @@ static struct move chooseRandomMove(Agent agent, Map m)
     if (numLegalRoads > 0)
     {
         // nextMove is randomly chosen from the legal roads
-        int k = rand() % numLegalRoads;
+        int k = agentRand(agent) % numLegalRoads;
         move = (struct move){legalRoads[k].to, legalRoads[k].length};
     }
     else
@@ -302,6 +506,19 @@ static struct move chooseRandomMove(Agent agent, Map m)
     return move;
 }
 
+/**
+ * Returns the next random number for the agent, taken from its own random
+ * number generator if it has been seeded and from rand() otherwise
+ */
+static int agentRand(Agent agent)
+{
+    if (agent->hasSeed)
+    {
+        return rand_r(&agent->seed);
+    }
+    return rand();
+}
+
 /**
  * Takes an array with all the possible roads and puts the ones the agent
  * has enough stamina for into the legalRoads array
@@ -327,6 +544,48 @@ static int filterRoads(Agent agent, struct road roads[], int numRoads,
  * cities requiring the same amount of stamina.
  */
 static struct move chooseClvMove(Agent agent, Map m)
+{
+    if (agent->engine == ENGINE_REFERENCE)
+    {
+        return referenceChooseClvMove(agent, m);
+    }
+
+    int numRoads = MapNumRoadsFrom(m, agent->location);
+    if (numRoads >= HUB_DEGREE && agent->visits == NULL)
+    {
+        return hubClvMove(agent, m);
+    }
+    if (numRoads >= HUB_DEGREE)
+    {
+        // a hub tree only hears about the agent's own visits, so with
+        // shared counts every affordable road is looked at instead
+        struct road *legalRoads = malloc(numRoads * sizeof(struct road));
+        if (legalRoads == NULL)
+        {
+            printNullError();
+        }
+        int numLegalRoads = MapGetRoadsByLength(m, agent->location,
+                                                agent->stamina, legalRoads);
+        struct move clvMove = nextClvMove(agent, numLegalRoads, legalRoads);
+        free(legalRoads);
+        return clvMove;
+    }
+
+    // The roads the agent can afford are a prefix of the length-sorted
+    // roads. Their order does not matter, since ties are broken on length
+    // and then on ID, and roads of the same length are sorted by ID. A city
+    // that is not a hub has few enough roads to decode onto the stack.
+    struct road legalRoads[HUB_DEGREE];
+    int numLegalRoads = MapGetRoadsByLength(m, agent->location,
+                                            agent->stamina, legalRoads);
+    return nextClvMove(agent, numLegalRoads, legalRoads);
+}
+
+/**
+ * The reference engine's version of chooseClvMove, which filters a copy of
+ * the roads in ID order
+ */
+static struct move referenceChooseClvMove(Agent agent, Map m)
 {
     struct road *roads = createRoads(m);
     struct road *legalRoads = createRoads(m);
@@ -360,7 +619,7 @@ static struct road *createRoads(Map m)
  * Returns the next move for the agent using the Clv strategy
  */
 static struct move nextClvMove(Agent agent, int numLegalRoads,
-                               struct road *legalRoads)
+                               const struct road *legalRoads)
 {
     struct move clvMove;
 
@@ -381,22 +640,194 @@ static struct move nextClvMove(Agent agent, int numLegalRoads,
     return clvMove;
 }
 
+/**
+ * Returns the same move as nextClvMove from a hub city, using the city's
+ * hub tree, which is made the first time the agent is there
+ */
+static struct move hubClvMove(Agent agent, Map m)
+{
+    // the trees hold copies of the map's roads, which change with its
+    // version
+    if (agent->hubTrees != NULL && agent->hubTreesVersion != MapVersion(m))
+    {
+        freeHubTrees(agent);
+    }
+    if (agent->hubTrees == NULL)
+    {
+        agent->hubTrees = AllocatorCalloc(agent->allocator, MapNumCities(m),
+                                          sizeof(HubTree));
+        agent->hubTreeSynced = AllocatorCalloc(agent->allocator,
+                                               MapNumCities(m), sizeof(int));
+        agent->visitLog = AllocatorMalloc(agent->allocator,
+                                          MapNumCities(m) * sizeof(int));
+        if (agent->hubTrees == NULL || agent->hubTreeSynced == NULL ||
+            agent->visitLog == NULL)
+        {
+            printNullError();
+        }
+        agent->hubTreesVersion = MapVersion(m);
+    }
+
+    int city = agent->location;
+    if (agent->hubTrees[city] == NULL)
+    {
+        makeVisitCounts(agent);
+        agent->hubTrees[city] = HubTreeNew(m, city,
+                                           agent->citiesVisitedCount);
+        agent->hubTreeSynced[city] = agent->visitLogLength;
+    }
+    syncHubTree(agent, city);
+
+    const struct road *best = HubTreeLeastVisited(agent->hubTrees[city],
+                                                  agent->stamina);
+    if (best == NULL)
+    {
+        return (struct move){agent->location, 0};
+    }
+    return (struct move){best->to, best->length};
+}
+
+/**
+ * Counts a visit to the city, logging it for the agent's hub trees. When the
+ * log is full, every tree is brought up to date and the log starts again.
+ */
+static void countVisit(Agent agent, int city)
+{
+    if (agent->visits != NULL)
+    {
+        VisitsAdd(agent->visits, city);
+        return;
+    }
+    makeVisitCounts(agent);
+    agent->citiesVisitedCount[city]++;
+    if (agent->hubTrees == NULL)
+    {
+        return;
+    }
+
+    int numCities = MapNumCities(agent->map);
+    if (agent->visitLogLength == numCities)
+    {
+        for (int hub = 0; hub < numCities; hub++)
+        {
+            if (agent->hubTrees[hub] != NULL)
+            {
+                syncHubTree(agent, hub);
+                agent->hubTreeSynced[hub] = 0;
+            }
+        }
+        agent->visitLogLength = 0;
+    }
+    agent->visitLog[agent->visitLogLength++] = city;
+}
+
+/**
+ * Counts a visit to the city the agent is about to move to. Shared counts
+ * only get it when the move is made, so that no detective sees another's
+ * visit while the team's moves are being worked out, whatever order they
+ * are worked out in.
+ */
+static void countPlannedVisit(Agent agent, int city)
+{
+    if (agent->visits != NULL)
+    {
+        agent->plannedVisit = city;
+        return;
+    }
+    countVisit(agent, city);
+}
+
+/**
+ * Returns the number of times the agent, or its team if it shares its
+ * counts, has visited the city
+ */
+static int visitCount(Agent agent, int city)
+{
+    if (agent->visits != NULL)
+    {
+        return VisitsCount(agent->visits, city);
+    }
+    if (agent->citiesVisitedCount == NULL)
+    {
+        return city == agent->startLocation;
+    }
+    return agent->citiesVisitedCount[city];
+}
+
+/**
+ * Gives the agent its own visit counts, with its starting city visited
+ * once, if it does not have them yet
+ */
+static void makeVisitCounts(Agent agent)
+{
+    if (agent->citiesVisitedCount != NULL)
+    {
+        return;
+    }
+    agent->citiesVisitedCount = AllocatorCalloc(agent->allocator,
+                                                MapNumCities(agent->map),
+                                                sizeof(int));
+    if (agent->citiesVisitedCount == NULL)
+    {
+        printNullError();
+    }
+    agent->citiesVisitedCount[agent->startLocation]++;
+}
+
+/**
+ * Tells the city's hub tree about the visits logged since it was last
+ * brought up to date
+ */
+static void syncHubTree(Agent agent, int city)
+{
+    for (int i = agent->hubTreeSynced[city]; i < agent->visitLogLength; i++)
+    {
+        HubTreeUpdate(agent->hubTrees[city], agent->visitLog[i]);
+    }
+    agent->hubTreeSynced[city] = agent->visitLogLength;
+}
+
+/**
+ * Frees the agent's hub trees and their log
+ */
+static void freeHubTrees(Agent agent)
+{
+    if (agent->hubTrees == NULL)
+    {
+        return;
+    }
+    for (int city = 0; city < MapNumCities(agent->map); city++)
+    {
+        if (agent->hubTrees[city] != NULL)
+        {
+            HubTreeFree(agent->hubTrees[city]);
+        }
+    }
+    AllocatorRelease(agent->allocator, agent->hubTrees);
+    AllocatorRelease(agent->allocator, agent->hubTreeSynced);
+    AllocatorRelease(agent->allocator, agent->visitLog);
+    agent->hubTrees = NULL;
+    agent->hubTreeSynced = NULL;
+    agent->visitLog = NULL;
+    agent->visitLogLength = 0;
+}
+
 /**
  * returns the next move based on the number of times that the agent has visited
  * the city and the stamina cost of the possible cities.
  */
-static struct move setClvMove(Agent agent, struct road *legalRoads,
+static struct move setClvMove(Agent agent, const struct road *legalRoads,
                               struct move clvMove, int *index)
 {
-    if (agent->citiesVisitedCount[legalRoads[*index].to] 
-        < agent->citiesVisitedCount[clvMove.to])
+    if (visitCount(agent, legalRoads[*index].to)
+        < visitCount(agent, clvMove.to))
     {
         // sets the move with the city that has been visited less.
         clvMove = (struct move){legalRoads[*index].to,
                                 legalRoads[*index].length};
     }
-    else if (agent->citiesVisitedCount[legalRoads[*index].to] 
-             == agent->citiesVisitedCount[clvMove.to])
+    else if (visitCount(agent, legalRoads[*index].to)
+             == visitCount(agent, clvMove.to))
     {
         // sets the move with the city with the lower stamina cost.
         if (legalRoads[*index].length < clvMove.staminaCost)
@@ -418,8 +849,9 @@ static struct move chooseDfsMove(Agent agent, Map m)
         // clear the dfsPath array.
         agent->dfsIndex = 0;
         agent->dfsPathNumElements = 0;
-        struct move *new = realloc(agent->dfsPath, MapNumCities(m) *
-                                                       sizeof(struct move));
+        struct move *new = AllocatorRealloc(agent->allocator, agent->dfsPath,
+                                            MapNumCities(m) *
+                                                sizeof(struct move));
         if (new == NULL)
         {
             printNullError();
@@ -479,7 +911,8 @@ static void dfsRec(Map m, int city, bool *visited, Agent agent)
         if (!visited[roads[i].to])
         {
             // checks for need of reallocation of dfsPath array
-            agent->dfsPath = reallocatePathCheck(&agent->dfsPath,
+            agent->dfsPath = reallocatePathCheck(agent->allocator,
+                                                 &agent->dfsPath,
                                                  agent->dfsPathNumElements,
                                                  &agent->dfsPathSize);
             agent->dfsPath[agent->dfsPathNumElements++] = (struct move)
@@ -488,7 +921,8 @@ static void dfsRec(Map m, int city, bool *visited, Agent agent)
 
             dfsRec(m, roads[i].to, visited, agent);
 
-            agent->dfsPath = reallocatePathCheck(&agent->dfsPath,
+            agent->dfsPath = reallocatePathCheck(agent->allocator,
+                                                 &agent->dfsPath,
                                                  agent->dfsPathNumElements,
                                                  &agent->dfsPathSize);
             // this adds to the path when the dfsPath is backtracking
@@ -504,14 +938,16 @@ static void dfsRec(Map m, int city, bool *visited, Agent agent)
  * Reallocates twice the memory to path array if the current array is filled
  * completely
  */
-static struct move *reallocatePathCheck(struct move **path, int numElements,
+static struct move *reallocatePathCheck(Allocator allocator,
+                                        struct move **path, int numElements,
                                         int *pathSize)
 {
     // reallocates the path with 2 times its size if the path is full.
     if (numElements >= *pathSize)
     {
         *pathSize *= 2;
-        struct move *new = realloc(*path, *pathSize * sizeof(struct move));
+        struct move *new = AllocatorRealloc(allocator, *path,
+                                            *pathSize * sizeof(struct move));
         if (new == NULL)
         {
             printNullError();
@@ -525,157 +961,279 @@ static struct move *reallocatePathCheck(struct move **path, int numElements,
 }
 
 /**
- * The following code was adapted from the comp2521 2024T3 Graph Traversal 
- * slides.
- * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
- * This uses the bfs algorithm to find the shortest path that takes the least
- * number of turns to the thief's location given by the informant.
+ * Returns the next move towards the goal or the nearest informant, searching
+ * from them first if the agent has no search for the current map
  */
-static void leastTurnsPath(Agent agent, Map m, int city, int stamina)
+static struct move chooseGoalMove(Agent agent, Map m)
 {
-    agent->ltpPathNumElements = 0;
-
-    struct costedMove *predecessor = malloc(MapNumCities(m) *
-                                            sizeof(struct costedMove));
-    if (predecessor == NULL)
+    if (agent->engine == ENGINE_REFERENCE)
     {
-        printNullError();
+        return referenceChooseGoalMove(agent, m);
     }
-
-    //initialises the predecessor array to have the maximum number of turns 
-    //and maximum total stamina cost
-    for (int i = 0; i < MapNumCities(m); i++)
+    if (agent->strategy == GETAWAY_SEEKING && agent->goal == -1)
     {
-        predecessor[i] = (struct costedMove){(struct move){-1, 0}, 0, INT_MAX};
+        return (struct move){agent->location, 0};
     }
 
-    Queue q = QueueNew();
-
-    //initialises the first predecessor with basic data
-    predecessor[city] = (struct costedMove){(struct move){-1, 0},
-                                            agent->stamina, 0};
-    QueueEnqueue(q, city);
-
-    ltpGetMoves(q, predecessor, stamina, m, agent);
-
-    copyPathIntoLtpPath(agent, predecessor);
-    free(predecessor);
-    QueueFree(q);
+    if (agent->fields == NULL)
+    {
+        agent->fields = FieldsNew(m, agent->allocator);
+        agent->ownsFields = true;
+    }
+    if (agent->strategy == GETAWAY_SEEKING)
+    {
+        return followField(agent, FieldsToCity(agent->fields, agent->goal,
+                                               agent->maxStamina));
+    }
+    return followField(agent, FieldsToInformants(agent->fields,
+                                                 agent->maxStamina));
 }
 
 /**
- * The following code was adapted from the comp2521 2024T3 Graph Traversal 
- * slides.
- * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
- * This gets the moves for leastTurnsPath until the queue that holds all the 
- * cities that still needs to be accounted for is empty
+ * The reference engine's version of chooseGoalMove, which searches from the
+ * goal or the informants before every move
  */
-static void ltpGetMoves(Queue q, struct costedMove *predecessor, int stamina,
-                        Map m, Agent agent)
+static struct move referenceChooseGoalMove(Agent agent, Map m)
 {
-    while (!QueueIsEmpty(q))
+    if (agent->strategy == GETAWAY_SEEKING && agent->goal == -1)
     {
-        int curr = QueueDequeue(q);
-
-        struct road *roads = createRoads(m);
+        return (struct move){agent->location, 0};
+    }
 
-        // Get all roads to adjacent cities
-        int numRoads = MapGetRoadsFrom(m, curr, roads);
-        // sorts the roads in ascending order by the length.
-        qsort(roads, numRoads, sizeof(struct road), compare);
+    struct costedMove *field = malloc(MapNumCities(m) *
+                                      sizeof(struct costedMove));
+    if (field == NULL)
+    {
+        printNullError();
+    }
+    searchFromGoal(agent, m, field);
+    struct move move = followField(agent, field);
+    free(field);
+    return move;
+}
 
-        fillQueue(roads, numRoads, q, curr, predecessor, agent->thiefLocation,
-                  stamina);
+/**
+ * Fills `field` with a reference search from the agent's goal, or from every
+ * informant city at once for INFORMANT_SEEKING, with the agent's maximum
+ * stamina. Roads are bidirectional, so the search gives the next road
+ * towards the goal or the nearest informant from every city.
+ */
+static void searchFromGoal(Agent agent, Map m, struct costedMove *field)
+{
+    if (agent->strategy == GETAWAY_SEEKING)
+    {
+        LeastTurnsReferenceSearch(m, agent->goal, agent->maxStamina,
+                                  agent->maxStamina, field);
+        return;
+    }
 
-        free(roads);
+    int *informants = malloc((MapNumInformants(m) + 1) * sizeof(int));
+    if (informants == NULL)
+    {
+        printNullError();
     }
+    int numInformants = 0;
+    for (int city = 0; city < MapNumCities(m); city++)
+    {
+        if (MapHasInformant(m, city))
+        {
+            informants[numInformants++] = city;
+        }
+    }
+    LeastTurnsReferenceMultiSearch(m, informants, numInformants,
+                                   agent->maxStamina, field);
+    free(informants);
 }
 
 /**
- * Comparison function used by qsort that sorts the two roads given as the
- * parameters by ascending order.
+ * Returns the road towards the goal from the agent's city, or a rest if the
+ * agent cannot afford it, is already at the goal or cannot reach it. An
+ * informant-seeking agent waits at the informant to be tipped off.
  */
-static int compare(const void *a, const void *b)
+static struct move followField(Agent agent, const struct costedMove *field)
 {
-    struct road *x = (struct road *)a;
-    struct road *y = (struct road *)b;
-    return x->length - y->length;
+    struct move next = field[agent->location].m;
+    if (next.to == -1 || agent->stamina < next.staminaCost)
+    {
+        return (struct move){agent->location, 0};
+    }
+    return next;
 }
 
 /**
- * The following code was adapted from the comp2521 2024T3 Graph Traversal 
- * slides.
- * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
- * Enqueues all the non-visited cities that is adjacent to the current city into
- * the queue.
+ * Starts a search from the thief's location for the agent to follow, unless
+ * it already has one from there for the current roads
  */
-static void fillQueue(struct road *roads, int roadSize, Queue q, 
-                      int currentCity, struct costedMove *predecessor,
-                      int thiefLocation, int stamina)
+static void startPlan(Agent agent, Map m, int thiefLocation)
 {
-    for (int i = 0; i < roadSize; i++)
+    agent->thiefLocation = -1;
+    agent->ltpPathNumElements = 0;
+    agent->ltpIndex = -1;
+    if (agent->planField != NULL && agent->planCity == thiefLocation &&
+        agent->planVersion == MapVersion(m))
     {
-        //if including this move in the path currently will result in an
-        //additional move to replenish stamina, then don't update
-        if (predecessor[currentCity].remainingStamina - roads[i].length 
-            < 0)
-        {
-            // replenish to max stamina
-            predecessor[currentCity].remainingStamina = stamina;
-            QueueEnqueue(q, currentCity);
-            predecessor[currentCity].numMovesTaken++;
-        } else if (pathNeedsUpdating(roads, currentCity, predecessor, i))
+        return;
+    }
+
+    if (agent->plan != NULL)
+    {
+        LeastTurnsFreeSearch(agent->plan);
+    }
+    if (agent->planField == NULL)
+    {
+        agent->planField = AllocatorMalloc(agent->allocator,
+                                           MapNumCities(m) *
+                                               sizeof(struct costedMove));
+        if (agent->planField == NULL)
         {
-            //sets the predecessor of the city that the road leads to. This will
-            //contain the remaining and overall stamina which takes the city's
-            //stamina cost into account
-            predecessor[roads[i].to] = (struct costedMove)
-                {(struct move){currentCity, roads[i].length},
-                  predecessor[currentCity].remainingStamina - roads[i].length,
-                  predecessor[currentCity].numMovesTaken + 1};
-            QueueEnqueue(q, roads[i].to);
+            printNullError();
         }
     }
+    // like AgentTipOffAll, the search is rooted at the thief so that it can
+    // be followed from wherever the agent has got to
+    agent->plan = LeastTurnsStartSearch(m, thiefLocation, agent->maxStamina,
+                                        agent->maxStamina, agent->planField);
+    agent->planCity = thiefLocation;
+    agent->planVersion = MapVersion(m);
 }
 
 /**
- * checks if the current road is leading to a city that has not been explored or
- * if it's the thief's location, checks if taken this road would lead to a path
- * with less turns than the current. If it takes the same number of turns, check
- * if it takes less stamina and returns true if it does.
+ * Carries on the agent's search within its budget and sets `*move` to the
+ * next move towards the thief. Returns false if the agent has no path from
+ * its city yet, so it should keep to its strategy for this move, or has
+ * reached the thief or found that it cannot, so the plan is over.
  */
-static bool pathNeedsUpdating(struct road *roads, int currentCity,
-                              struct costedMove *predecessor, int index)
+static bool followPlan(Agent agent, Map m, struct move *move)
 {
-    bool needsUpdating = true;
-
-    //checks if this road leads to a path with less turns used
-    if (predecessor[currentCity].numMovesTaken + 1 <
-        predecessor[roads[index].to].numMovesTaken)
+    if (agent->planVersion != MapVersion(m))
     {
-        needsUpdating = true;
+        startPlan(agent, m, agent->planCity);
     }
-    else if (predecessor[currentCity].numMovesTaken + 1 ==
-                predecessor[roads[index].to].numMovesTaken)
+    if (agent->plan != NULL)
     {
-        //checks if this road leads to a path which leaves the agent with the
-        //most stamina
-        if (predecessor[currentCity].remainingStamina - roads[index].length
-            > predecessor[roads[index].to].remainingStamina)
+        if (LeastTurnsContinueSearch(agent->plan, agent->planningBudget))
         {
-            needsUpdating = true;
+            LeastTurnsFreeSearch(agent->plan);
+            agent->plan = NULL;
         }
         else
         {
-            needsUpdating = false;
+            agent->numBudgetHits++;
         }
     }
+
+    if (agent->location == agent->planCity ||
+        (agent->plan == NULL &&
+         agent->planField[agent->location].numMovesTaken == INT_MAX))
+    {
+        stopPlan(agent);
+        return false;
+    }
+    if (agent->planField[agent->location].numMovesTaken == INT_MAX)
+    {
+        return false;
+    }
+
+    *move = followField(agent, agent->planField);
+    if (move->to != agent->location)
+    {
+        countPlannedVisit(agent, move->to);
+    }
+    return true;
+}
+
+/**
+ * Abandons the agent's search and its paths
+ */
+static void stopPlan(Agent agent)
+{
+    if (agent->plan != NULL)
+    {
+        LeastTurnsFreeSearch(agent->plan);
+        agent->plan = NULL;
+    }
+    AllocatorRelease(agent->allocator, agent->planField);
+    agent->planField = NULL;
+    agent->planCity = -1;
+}
+
+/**
+ * The following code was adapted from the comp2521 2024T3 Graph Traversal 
+ * slides.
+ * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+ * This uses the bfs algorithm to find the shortest path that takes the least
+ * number of turns to the thief's location given by the informant.
+ */
+static void leastTurnsPath(Agent agent, Map m, int city, int stamina)
+{
+    agent->ltpPathNumElements = 0;
+
+    struct costedMove *predecessor = malloc(MapNumCities(m) *
+                                            sizeof(struct costedMove));
+    if (predecessor == NULL)
+    {
+        printNullError();
+    }
+
+    if (agent->landmarks != NULL && LandmarksIsCurrent(agent->landmarks, m))
+    {
+        LeastTurnsGoalSearch(m, city, agent->thiefLocation, agent->stamina,
+                             stamina, agent->landmarks, predecessor);
+    }
+    else if (agent->searchPool != NULL)
+    {
+        LeastTurnsParallelSearch(m, city, agent->stamina, stamina,
+                                 predecessor, agent->searchPool);
+    }
     else
     {
-        needsUpdating = false;
+        LeastTurnsSearch(m, city, agent->stamina, stamina, predecessor);
     }
 
-    return needsUpdating;
+    copyPathIntoLtpPath(agent, predecessor);
+    free(predecessor);
+}
+
+/**
+ * The reference engine's version of leastTurnsPath, which searches from
+ * scratch every time
+ */
+static void referenceLeastTurnsPath(Agent agent, Map m, int city,
+                                    int stamina)
+{
+    agent->ltpPathNumElements = 0;
+
+    struct costedMove *predecessor = malloc(MapNumCities(m) *
+                                            sizeof(struct costedMove));
+    if (predecessor == NULL)
+    {
+        printNullError();
+    }
+
+    LeastTurnsReferenceSearch(m, city, agent->stamina, stamina, predecessor);
+
+    copyPathIntoLtpPath(agent, predecessor);
+    free(predecessor);
+}
+
+/**
+ * The reference engine's version of the path AgentTipOffAll gives an agent,
+ * which comes from a search from the thief's location of its own
+ */
+static void referenceTipOffPath(Agent agent, Map m, int thiefLocation)
+{
+    struct costedMove *successor = malloc(MapNumCities(m) *
+                                          sizeof(struct costedMove));
+    if (successor == NULL)
+    {
+        printNullError();
+    }
+
+    LeastTurnsReferenceSearch(m, thiefLocation, agent->maxStamina,
+                              agent->maxStamina, successor);
+
+    copyReversePathIntoLtpPath(agent, successor);
+    free(successor);
 }
 
 /**
@@ -686,6 +1244,12 @@ static void copyPathIntoLtpPath(Agent agent, struct costedMove *predecessor)
 {
     int currentCityIndex = agent->thiefLocation;
 
+    // a closed road can leave the thief out of reach
+    if (predecessor[currentCityIndex].numMovesTaken == INT_MAX)
+    {
+        currentCityIndex = agent->location;
+    }
+
     while (currentCityIndex != agent->location)
     {
         agent->ltpPath[agent->ltpPathNumElements++] = (struct move){
@@ -696,6 +1260,61 @@ static void copyPathIntoLtpPath(Agent agent, struct costedMove *predecessor)
     agent->ltpIndex = agent->ltpPathNumElements - 1;
 }
 
+/**
+ * Copies the path from the agent's location to the thief out of a search
+ * that was rooted at the thief's location. Each city's predecessor in such a
+ * search is the next city on the way to the thief, so the moves are found
+ * in the order they are made and are stored back to front in ltpPath.
+ */
+static void copyReversePathIntoLtpPath(Agent agent,
+                                       struct costedMove *successor)
+{
+    int numMoves = 0;
+    for (int city = agent->location; successor[city].m.to != -1;
+         city = successor[city].m.to)
+    {
+        numMoves++;
+    }
+
+    agent->ltpPathNumElements = numMoves;
+    int index = numMoves - 1;
+    for (int city = agent->location; successor[city].m.to != -1;
+         city = successor[city].m.to)
+    {
+        agent->ltpPath[index--] = (struct move){successor[city].m.to,
+                                                successor[city].m.staminaCost};
+    }
+
+    agent->ltpIndex = agent->ltpPathNumElements - 1;
+}
+
+/**
+ * Copies the path from the agent's location to the thief out of a least
+ * turns table. These are the same moves copyReversePathIntoLtpPath would
+ * copy out of a search from the thief's location.
+ */
+static void copyTablePathIntoLtpPath(Agent agent, LtpTable table,
+                                     int thiefLocation)
+{
+    int numMoves = 0;
+    for (int city = agent->location;
+         LtpTableNextMove(table, city, thiefLocation).to != -1;
+         city = LtpTableNextMove(table, city, thiefLocation).to)
+    {
+        numMoves++;
+    }
+
+    agent->ltpPathNumElements = numMoves;
+    int index = numMoves - 1;
+    for (int city = agent->location; index >= 0; index--)
+    {
+        agent->ltpPath[index] = LtpTableNextMove(table, city, thiefLocation);
+        city = agent->ltpPath[index].to;
+    }
+
+    agent->ltpIndex = agent->ltpPathNumElements - 1;
+}
+
 /**
  * Executes a given move by updating the agent's internal state
  */
@@ -710,10 +1329,153 @@ void AgentMakeNextMove(Agent agent, struct move move)
         agent->stamina -= move.staminaCost;
     }
     agent->location = move.to;
-    agent->citiesVisitedCount[move.to]++;
+    if (agent->plannedVisit != -1)
+    {
+        countVisit(agent, agent->plannedVisit);
+        agent->plannedVisit = -1;
+    }
+    countVisit(agent, move.to);
     agent->thiefLocation = -1;
 }
 
+/**
+ * Gives the agent a precomputed least turns table to use for tip-offs
+ */
+bool AgentSetLtpTable(Agent agent, LtpTable table)
+{
+    if (table != NULL && LtpTableStamina(table) != agent->maxStamina)
+    {
+        return false;
+    }
+    agent->ltpTable = table;
+    return true;
+}
+
+/**
+ * Sets the city the agent heads for
+ */
+void AgentSetGoal(Agent agent, int city)
+{
+    assert(city >= -1 && city < MapNumCities(agent->map));
+    agent->goal = city;
+}
+
+/**
+ * Gives the agent fields to follow in place of its own
+ */
+void AgentSetFields(Agent agent, Fields fields)
+{
+    if (agent->ownsFields)
+    {
+        FieldsFree(agent->fields);
+    }
+    agent->fields = fields;
+    agent->ownsFields = false;
+}
+
+/**
+ * Gives the agent landmarks to direct its least turns searches
+ */
+void AgentSetLandmarks(Agent agent, Landmarks landmarks)
+{
+    agent->landmarks = landmarks;
+}
+
+/**
+ * Sets the pool the agent's least turns searches run on
+ */
+void AgentSetSearchPool(Agent agent, Pool pool)
+{
+    agent->searchPool = pool;
+}
+
+/**
+ * Moves the agent's visits so far into the shared counts, or copies the
+ * shared counts into new counts of its own
+ */
+void AgentSetVisits(Agent agent, Visits visits)
+{
+    if (visits == agent->visits)
+    {
+        return;
+    }
+
+    if (visits == NULL)
+    {
+        Visits shared = agent->visits;
+        agent->visits = NULL;
+        makeVisitCounts(agent);
+        for (int city = 0; city < MapNumCities(agent->map); city++)
+        {
+            agent->citiesVisitedCount[city] = VisitsCount(shared, city);
+        }
+        return;
+    }
+
+    if (agent->visits == NULL && agent->citiesVisitedCount == NULL)
+    {
+        VisitsAdd(visits, agent->startLocation);
+    }
+    else if (agent->visits == NULL)
+    {
+        for (int city = 0; city < MapNumCities(agent->map); city++)
+        {
+            for (int i = 0; i < agent->citiesVisitedCount[city]; i++)
+            {
+                VisitsAdd(visits, city);
+            }
+        }
+    }
+    // the hub trees point at the agent's own counts
+    freeHubTrees(agent);
+    AllocatorRelease(agent->allocator, agent->citiesVisitedCount);
+    agent->citiesVisitedCount = NULL;
+    agent->visits = visits;
+}
+
+/**
+ * Sets the team that plans the agent's moves
+ */
+void AgentSetTeam(Agent agent, Team team)
+{
+    agent->team = team;
+}
+
+/**
+ * Sets how many cities the agent's search may take on each move
+ */
+void AgentSetPlanningBudget(Agent agent, long maxCities)
+{
+    assert(maxCities >= 0);
+    agent->planningBudget = maxCities;
+}
+
+/**
+ * Returns the number of moves on which the budget ran out
+ */
+long AgentNumBudgetHits(Agent agent)
+{
+    return agent->numBudgetHits;
+}
+
+/**
+ * Sets the engine the agent uses to work out its moves
+ */
+void AgentSetEngine(Agent agent, int engine)
+{
+    assert(engine == ENGINE_OPTIMIZED || engine == ENGINE_REFERENCE);
+    agent->engine = engine;
+}
+
+/**
+ * Gives the agent its own random number generator
+ */
+void AgentSeed(Agent agent, unsigned int seed)
+{
+    agent->hasSeed = true;
+    agent->seed = seed;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Learning information
 
@@ -725,6 +1487,151 @@ void AgentTipOff(Agent agent, int thiefLocation)
     agent->thiefLocation = thiefLocation;
 }
 
+/**
+ * Tells every agent in the array where the thief is and plans their paths
+ * straight away. Agents are grouped by their maximum stamina and the agents
+ * at full stamina in each group share one least turns search rooted at the
+ * thief's location.
+ */
+void AgentTipOffAll(Agent agents[], int numAgents, int thiefLocation, Map m)
+{
+    Agent *sorted = malloc(numAgents * sizeof(Agent));
+    struct costedMove *successor = malloc(MapNumCities(m) *
+                                          sizeof(struct costedMove));
+    if (sorted == NULL || successor == NULL)
+    {
+        printNullError();
+    }
+    memcpy(sorted, agents, numAgents * sizeof(Agent));
+    qsort(sorted, numAgents, sizeof(Agent), compareMaxStamina);
+
+    int classStart = 0;
+    while (classStart < numAgents)
+    {
+        int stamina = sorted[classStart]->maxStamina;
+        int classEnd = classStart;
+        while (classEnd < numAgents && sorted[classEnd]->maxStamina == stamina)
+        {
+            classEnd++;
+        }
+
+        // agents at full stamina follow a precomputed table if the class
+        // has one, otherwise the search from the thief's location, made once
+        // the first of them needs it. Agents using the reference engine
+        // search on their own.
+        bool reference = sorted[classStart]->engine == ENGINE_REFERENCE;
+        LtpTable table = NULL;
+        if (!reference)
+        {
+            table = findLtpTable(&sorted[classStart], classEnd - classStart,
+                                 m);
+        }
+        bool searched = false;
+
+        for (int i = classStart; i < classEnd; i++)
+        {
+            if (sorted[i]->stamina < stamina)
+            {
+                forwardTipOffPath(sorted[i], m, thiefLocation);
+            }
+            else if (reference)
+            {
+                referenceTipOffPath(sorted[i], m, thiefLocation);
+            }
+            else if (table != NULL)
+            {
+                copyTablePathIntoLtpPath(sorted[i], table, thiefLocation);
+            }
+            else
+            {
+                if (!searched)
+                {
+                    searchFromThief(sorted[i], m, thiefLocation, successor);
+                    searched = true;
+                }
+                copyReversePathIntoLtpPath(sorted[i], successor);
+            }
+            // the path is already planned, so AgentGetNextMove should follow
+            // it rather than searching again
+            stopPlan(sorted[i]);
+            sorted[i]->thiefLocation = -1;
+            sorted[i]->dfsIndex = sorted[i]->dfsPathNumElements;
+        }
+        classStart = classEnd;
+    }
+
+    free(successor);
+    free(sorted);
+}
+
+/**
+ * Fills `successor` with a least turns search from the thief's location for
+ * agents with the agent's maximum stamina, on the agent's search pool if it
+ * has one
+ */
+static void searchFromThief(Agent agent, Map m, int thiefLocation,
+                            struct costedMove *successor)
+{
+    int stamina = agent->maxStamina;
+    if (agent->searchPool != NULL)
+    {
+        LeastTurnsParallelSearch(m, thiefLocation, stamina, stamina,
+                                 successor, agent->searchPool);
+    }
+    else
+    {
+        LeastTurnsSearch(m, thiefLocation, stamina, stamina, successor);
+    }
+}
+
+/**
+ * Plans the path of a tipped-off agent below full stamina with a search
+ * from its own city. A search from the thief's location finds the paths
+ * for an agent that sets out with full stamina, which can take more turns
+ * than the least for this agent.
+ */
+static void forwardTipOffPath(Agent agent, Map m, int thiefLocation)
+{
+    agent->thiefLocation = thiefLocation;
+    if (agent->engine == ENGINE_REFERENCE)
+    {
+        referenceLeastTurnsPath(agent, m, agent->location, agent->maxStamina);
+    }
+    else
+    {
+        leastTurnsPath(agent, m, agent->location, agent->maxStamina);
+    }
+}
+
+/**
+ * Returns a table held by any of the given agents which is for the current
+ * roads of the map, or NULL if there is none
+ * NOTE: All the agents are assumed to have the same maximum stamina
+ */
+static LtpTable findLtpTable(Agent agents[], int numAgents, Map m)
+{
+    for (int i = 0; i < numAgents; i++)
+    {
+        LtpTable table = agents[i]->ltpTable;
+        if (table != NULL && LtpTableIsCurrent(table, m))
+        {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Comparison function used by qsort that sorts agents by ascending maximum
+ * stamina.
+ */
+static int compareMaxStamina(const void *a, const void *b)
+{
+    Agent x = *(Agent *)a;
+    Agent y = *(Agent *)b;
+    return x->maxStamina - y->maxStamina;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Displaying state
 
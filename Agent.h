@@ -1,10 +1,10 @@
 // Interface to the Agent ADT
 
-// !!! DO NOT MODIFY THIS FILE !!!
-
 #ifndef AGENT_H
 #define AGENT_H
 
+#include <stdbool.h>
+
 #include "Map.h"
 
 // Constants to represent search strategies used by the agents
@@ -12,8 +12,26 @@
 #define RANDOM                  0
 #define CHEAPEST_LEAST_VISITED  1
 #define DFS                     2
+#define GETAWAY_SEEKING         3 // for the thief: heads for the city given
+                                  // to AgentSetGoal
+#define INFORMANT_SEEKING       4 // for detectives: heads for the nearest
+                                  // informant city and waits there
+#define COORDINATED             5 // for detectives: plans its moves together
+                                  // with the rest of its team (see Team.h)
+
+// Constants to represent the engines that agents can use to work out moves.
+// Both engines always choose the same moves.
+#define ENGINE_OPTIMIZED        0 // the default
+#define ENGINE_REFERENCE        1 // the straightforward implementation that
+                                  // optimizations are checked against
 
 typedef struct agent *Agent;
+typedef struct ltpTable *LtpTable; // see LtpTable.h
+typedef struct landmarks *Landmarks; // see Landmarks.h
+typedef struct team *Team; // see Team.h
+typedef struct pool *Pool; // see Pool.h
+typedef struct visits *Visits; // see Visits.h
+typedef struct fields *Fields; // see Fields.h
 
 struct move {
     int to;
@@ -27,6 +45,14 @@ struct move {
  */
 Agent AgentNew(int start, int stamina, int strategy, Map m, char *name);
 
+/**
+ * Like AgentNew, but everything the agent keeps between moves comes from the
+ * given allocator, or from malloc if it is NULL
+ * NOTE: The allocator must outlive the agent
+ */
+Agent AgentNewWithAllocator(int start, int stamina, int strategy, Map m,
+                            char *name, Allocator allocator);
+
 /**
  * Frees all memory allocated to the agent
  */
@@ -50,6 +76,17 @@ int AgentLocation(Agent agent);
  */
 int AgentStamina(Agent agent);
 
+/**
+ * Gets the stamina the agent has after resting
+ */
+int AgentMaxStamina(Agent agent);
+
+/**
+ * Returns true if the agent's next move will follow a path towards where
+ * it was told the thief is, rather than its strategy
+ */
+bool AgentIsChasing(Agent agent);
+
 ////////////////////////////////////////////////////////////////////////
 // Making moves
 
@@ -64,6 +101,113 @@ struct move AgentGetNextMove(Agent agent, Map m);
  */
 void AgentMakeNextMove(Agent agent, struct move move);
 
+/**
+ * Sets the engine the agent uses to work out its moves
+ */
+void AgentSetEngine(Agent agent, int engine);
+
+/**
+ * Gives the agent a least turns table. When the agent is tipped off by
+ * AgentTipOffAll at full stamina it follows the table instead of searching,
+ * as long as the map's roads have not changed since the table was made.
+ * Returns false and leaves the agent unchanged if the table was built for a
+ * different maximum stamina. Pass NULL to stop using a table.
+ * NOTE: The table belongs to the caller and must outlive its use
+ */
+bool AgentSetLtpTable(Agent agent, LtpTable table);
+
+/**
+ * Gives the agent landmarks for the map. While the map's roads have not
+ * changed since the landmarks were made, the agent's least turns searches
+ * head for the thief and stop exploring cities that cannot be on a path
+ * with the fewest turns, rather than searching the whole map. The path
+ * found takes the same number of turns and leaves the same stamina as
+ * without landmarks, but where several paths do that it may be a different
+ * one of them. Pass NULL to stop using landmarks.
+ * NOTE: The landmarks belong to the caller and must outlive their use
+ */
+void AgentSetLandmarks(Agent agent, Landmarks landmarks);
+
+/**
+ * Gives the agent a pool to run its least turns searches after a tip-off
+ * on, with LeastTurnsParallelSearch. The paths found take the same number
+ * of turns and leave the same stamina as without the pool, but where
+ * several paths do that it may be a different one of them. Searches with
+ * landmarks or a planning budget do not use the pool, and nor does the
+ * reference engine unless tip-offs are batched.
+ * Pass NULL to search on the calling thread again (the default).
+ * NOTE: The pool belongs to the caller and must outlive its use. It must not
+ *       be the pool the agent's moves are worked out on (see GameSetPool).
+ */
+void AgentSetSearchPool(Agent agent, Pool pool);
+
+/**
+ * Limits the work the agent does on any one move after a tip-off from
+ * AgentTipOff. Instead of searching the whole map at once, the agent's
+ * least turns search from the thief's location processes at most
+ * `maxCities` cities per move, carrying on where it left off on the next
+ * move. While its search has no path from the agent's city the agent keeps
+ * to its strategy; once it has one the agent follows it, and the paths get
+ * better until the search finishes. Pass 0 for no limit (the default).
+ * NOTE: The agent may make different moves with a budget than without one,
+ *       and the reference engine ignores it
+ */
+void AgentSetPlanningBudget(Agent agent, long maxCities);
+
+/**
+ * Returns the number of moves on which the agent's planning budget ran out
+ * before its search finished
+ */
+long AgentNumBudgetHits(Agent agent);
+
+/**
+ * Sets the city an agent using the GETAWAY_SEEKING strategy heads for. The
+ * agent follows the least turns path to it from its fields (see Fields.h),
+ * which search from the goal once and again only when the map's roads
+ * change, so each move after that is a lookup.
+ * An agent using the INFORMANT_SEEKING strategy needs no goal: it follows
+ * the least turns path to the nearest informant in the same way, from one
+ * search from all of the map's informant cities at once.
+ */
+void AgentSetGoal(Agent agent, int city);
+
+/**
+ * Gives the agent fields to follow towards its goal or the nearest
+ * informant, which it shares with other agents, so that agents with the
+ * same maximum stamina share one search. Without them, the agent makes
+ * fields of its own on its first move. Pass NULL to go back to fields of
+ * its own.
+ * NOTE: The fields must be for the map the agent moves on, belong to the
+ *       caller and must outlive their use
+ */
+void AgentSetFields(Agent agent, Fields fields);
+
+/**
+ * Gives an agent using the COORDINATED strategy the team that plans its
+ * moves. Without a team, the agent moves like CHEAPEST_LEAST_VISITED.
+ * TeamAddMember calls this, so it is rarely needed on its own.
+ * NOTE: The team must outlive its use
+ */
+void AgentSetTeam(Agent agent, Team team);
+
+/**
+ * Makes the agent count its visits in the given counts, which it shares
+ * with the rest of its team, instead of in counts of its own. Using the
+ * CHEAPEST_LEAST_VISITED strategy, it then heads for the cities the team
+ * has visited least. The visits it has made so far are added to the shared
+ * counts. Pass NULL to go back to counts of its own, which start as a copy
+ * of the shared counts.
+ * NOTE: The counts belong to the caller and must outlive their use
+ */
+void AgentSetVisits(Agent agent, Visits visits);
+
+/**
+ * Gives the agent its own random number generator, started from the given
+ * seed, instead of using rand(). Agents with their own generators can make
+ * random moves in different threads and still repeat the same game.
+ */
+void AgentSeed(Agent agent, unsigned int seed);
+
 ////////////////////////////////////////////////////////////////////////
 // Learning information
 
@@ -72,6 +216,17 @@ void AgentMakeNextMove(Agent agent, struct move move);
  */
 void AgentTipOff(Agent agent, int thiefLocation);
 
+/**
+ * Tells all of the given agents where the thief is and plans their paths
+ * to the thief immediately. The agents at full stamina in every group of
+ * agents with the same maximum stamina share one search from the thief's
+ * location. An agent below full stamina searches from its own city, as
+ * AgentTipOff would, since a path from the thief's location takes the least
+ * turns only for an agent that sets out with full stamina. Agents using the
+ * reference engine each make a search of their own.
+ */
+void AgentTipOffAll(Agent agents[], int numAgents, int thiefLocation, Map m);
+
 ////////////////////////////////////////////////////////////////////////
 // Displaying state
 
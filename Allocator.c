@@ -0,0 +1,474 @@
+// Implementation of the Allocator ADT
+// Every block handed out by an allocator starts with a header giving the
+// number of bytes asked for and the number of bytes the block has room for,
+// so that blocks can be counted off when they are released and an arena
+// can grow a block in place while it has room. An account hands out its
+// parent's blocks unchanged, and so uses its parent's headers.
+//
+// An arena's chunks are kept in a list and handed out from the front of the
+// newest one. A block too big for a chunk of the usual size gets a chunk of
+// its own. A paged arena gets its chunks straight from mmap, in whole huge
+// pages if it asks for them, so that they can be backed by transparent huge
+// pages and placed on a NUMA node before anything touches them.
+
+#define _GNU_SOURCE // for MAP_ANONYMOUS and MADV_HUGEPAGE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "Allocator.h"
+#include "Numa.h"
+
+#define ALIGNMENT 16 // of every block, like malloc's
+#define PAGE_SIZE 4096
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#define HEAP 0
+#define ARENA 1
+#define ACCOUNT 2
+
+struct header
+{
+    size_t size;
+    size_t capacity;
+};
+
+struct chunk
+{
+    struct chunk *next;
+    size_t size; // of a chunk from mmap, or 0 for one from malloc
+};
+
+struct allocator
+{
+    int kind;
+    pthread_mutex_t lock;
+    size_t bytesInUse;
+    size_t peakBytes;
+    size_t limit; // 0 for no limit
+
+    Allocator parent; // for an account
+
+    // for an arena
+    struct chunk *chunks;
+    size_t chunkSize;
+    char *next;
+    char *end;
+    bool paged;
+    bool hugePages;
+    int node; // the NUMA node a paged arena's chunks are on, or -1
+};
+
+static void printNullError(void);
+static Allocator newAllocator(int kind);
+static bool count(Allocator a, size_t oldSize, size_t newSize);
+static struct header *newBlock(Allocator a, size_t capacity);
+static struct chunk *newChunk(Allocator a, size_t size);
+static size_t roundUp(size_t size);
+
+/**
+ * Creates an allocator of the heap kind
+ */
+Allocator AllocatorNewHeap(void)
+{
+    return newAllocator(HEAP);
+}
+
+/**
+ * Creates an arena with no chunks, which are made as they are needed
+ */
+Allocator AllocatorNewArena(size_t chunkSize)
+{
+    Allocator a = newAllocator(ARENA);
+    a->chunkSize = chunkSize;
+    return a;
+}
+
+/**
+ * Creates an arena whose chunks will come from mmap
+ */
+Allocator AllocatorNewPagedArena(size_t chunkSize, int node, bool hugePages)
+{
+    Allocator a = AllocatorNewArena(chunkSize);
+    a->paged = true;
+    a->hugePages = hugePages;
+    a->node = node;
+    return a;
+}
+
+/**
+ * Creates an account of the parent
+ */
+Allocator AllocatorNewAccount(Allocator parent)
+{
+    assert(parent != NULL);
+    Allocator a = newAllocator(ACCOUNT);
+    a->parent = parent;
+    return a;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Creates an allocator of the given kind with nothing in use
+ */
+static Allocator newAllocator(int kind)
+{
+    Allocator a = malloc(sizeof(struct allocator));
+    if (a == NULL)
+    {
+        printNullError();
+    }
+    a->kind = kind;
+    pthread_mutex_init(&a->lock, NULL);
+    a->bytesInUse = 0;
+    a->peakBytes = 0;
+    a->limit = 0;
+    a->parent = NULL;
+    a->chunks = NULL;
+    a->chunkSize = 0;
+    a->next = NULL;
+    a->end = NULL;
+    a->paged = false;
+    a->hugePages = false;
+    a->node = -1;
+    return a;
+}
+
+/**
+ * Frees an arena's chunks and then the allocator
+ */
+void AllocatorFree(Allocator a)
+{
+    struct chunk *curr = a->chunks;
+    while (curr != NULL)
+    {
+        struct chunk *temp = curr;
+        curr = curr->next;
+        if (temp->size != 0)
+        {
+            munmap(temp, temp->size);
+        }
+        else
+        {
+            free(temp);
+        }
+    }
+    pthread_mutex_destroy(&a->lock);
+    free(a);
+}
+
+/**
+ * Sets the most bytes the allocator may have in use
+ */
+void AllocatorSetLimit(Allocator a, size_t maxBytes)
+{
+    pthread_mutex_lock(&a->lock);
+    a->limit = maxBytes;
+    pthread_mutex_unlock(&a->lock);
+}
+
+/**
+ * Counts the block, then gets it from the parent, malloc or the arena
+ */
+void *AllocatorMalloc(Allocator a, size_t size)
+{
+    if (a == NULL)
+    {
+        return malloc(size);
+    }
+    if (!count(a, 0, size))
+    {
+        return NULL;
+    }
+
+    if (a->kind == ACCOUNT)
+    {
+        void *p = AllocatorMalloc(a->parent, size);
+        if (p == NULL)
+        {
+            count(a, size, 0);
+        }
+        return p;
+    }
+
+    struct header *h = newBlock(a, size);
+    if (h == NULL)
+    {
+        count(a, size, 0);
+        return NULL;
+    }
+    h->size = size;
+    return h + 1;
+}
+
+/**
+ * Gets a block and clears it
+ */
+void *AllocatorCalloc(Allocator a, size_t numElements, size_t size)
+{
+    if (a == NULL)
+    {
+        return calloc(numElements, size);
+    }
+    if (size != 0 && numElements > (size_t)-1 / size)
+    {
+        return NULL;
+    }
+    void *p = AllocatorMalloc(a, numElements * size);
+    if (p != NULL)
+    {
+        memset(p, 0, numElements * size);
+    }
+    return p;
+}
+
+/**
+ * Grows or shrinks the block in place if it has room, or otherwise moves it
+ * to a new block
+ */
+void *AllocatorRealloc(Allocator a, void *p, size_t size)
+{
+    if (a == NULL)
+    {
+        return realloc(p, size);
+    }
+    if (p == NULL)
+    {
+        return AllocatorMalloc(a, size);
+    }
+
+    struct header *h = (struct header *)p - 1;
+    size_t oldSize = h->size;
+    if (!count(a, oldSize, size))
+    {
+        return NULL;
+    }
+
+    if (a->kind == ACCOUNT)
+    {
+        void *q = AllocatorRealloc(a->parent, p, size);
+        if (q == NULL)
+        {
+            count(a, size, oldSize);
+        }
+        return q;
+    }
+
+    if (size <= h->capacity)
+    {
+        h->size = size;
+        return p;
+    }
+
+    struct header *new;
+    if (a->kind == HEAP)
+    {
+        new = realloc(h, sizeof(struct header) + size);
+    }
+    else
+    {
+        // the old block's memory stays in the arena until it is freed
+        new = newBlock(a, size);
+        if (new != NULL)
+        {
+            memcpy(new + 1, p, oldSize);
+        }
+    }
+    if (new == NULL)
+    {
+        count(a, size, oldSize);
+        return NULL;
+    }
+    new->size = size;
+    if (a->kind == HEAP)
+    {
+        new->capacity = size;
+    }
+    return new + 1;
+}
+
+/**
+ * Takes the block off the count and frees it unless it is in an arena
+ */
+void AllocatorRelease(Allocator a, void *p)
+{
+    if (a == NULL || p == NULL)
+    {
+        free(p);
+        return;
+    }
+
+    struct header *h = (struct header *)p - 1;
+    count(a, h->size, 0);
+    if (a->kind == ACCOUNT)
+    {
+        AllocatorRelease(a->parent, p);
+    }
+    else if (a->kind == HEAP)
+    {
+        free(h);
+    }
+}
+
+/**
+ * Copies the string with its terminating null character
+ */
+char *AllocatorStrdup(Allocator a, const char *s)
+{
+    size_t size = strlen(s) + 1;
+    char *copy = AllocatorMalloc(a, size);
+    if (copy != NULL)
+    {
+        memcpy(copy, s, size);
+    }
+    return copy;
+}
+
+/**
+ * Returns the bytes in use
+ */
+size_t AllocatorBytesInUse(Allocator a)
+{
+    pthread_mutex_lock(&a->lock);
+    size_t bytes = a->bytesInUse;
+    pthread_mutex_unlock(&a->lock);
+    return bytes;
+}
+
+/**
+ * Returns the peak bytes in use
+ */
+size_t AllocatorPeakBytes(Allocator a)
+{
+    pthread_mutex_lock(&a->lock);
+    size_t bytes = a->peakBytes;
+    pthread_mutex_unlock(&a->lock);
+    return bytes;
+}
+
+/**
+ * Changes a block's count from `oldSize` to `newSize` bytes. Returns false
+ * and leaves the count alone if that would pass the limit.
+ */
+static bool count(Allocator a, size_t oldSize, size_t newSize)
+{
+    pthread_mutex_lock(&a->lock);
+    size_t bytes = a->bytesInUse - oldSize + newSize;
+    bool ok = newSize <= oldSize || a->limit == 0 || bytes <= a->limit;
+    if (ok)
+    {
+        a->bytesInUse = bytes;
+        if (bytes > a->peakBytes)
+        {
+            a->peakBytes = bytes;
+        }
+    }
+    pthread_mutex_unlock(&a->lock);
+    return ok;
+}
+
+/**
+ * Returns a new block with room for at least `capacity` bytes after its
+ * header, from malloc or from the front of the arena's newest chunk, or
+ * NULL if there is no memory left
+ */
+static struct header *newBlock(Allocator a, size_t capacity)
+{
+    if (a->kind == HEAP)
+    {
+        struct header *h = malloc(sizeof(struct header) + capacity);
+        if (h != NULL)
+        {
+            h->capacity = capacity;
+        }
+        return h;
+    }
+
+    size_t size = sizeof(struct header) + roundUp(capacity);
+    pthread_mutex_lock(&a->lock);
+    if (a->next == NULL || (size_t)(a->end - a->next) < size)
+    {
+        size_t chunkSize = roundUp(sizeof(struct chunk)) +
+                           (size > a->chunkSize ? size : a->chunkSize);
+        struct chunk *c = newChunk(a, chunkSize);
+        if (c == NULL)
+        {
+            pthread_mutex_unlock(&a->lock);
+            return NULL;
+        }
+        chunkSize = c->size != 0 ? c->size : chunkSize;
+        c->next = a->chunks;
+        a->chunks = c;
+        a->next = (char *)c + roundUp(sizeof(struct chunk));
+        a->end = (char *)c + chunkSize;
+    }
+    struct header *h = (struct header *)a->next;
+    a->next += size;
+    pthread_mutex_unlock(&a->lock);
+
+    h->capacity = roundUp(capacity);
+    return h;
+}
+
+/**
+ * Returns a chunk of at least `size` bytes from malloc or, for a paged
+ * arena, from mmap rounded up to whole pages, or NULL if there is no memory
+ * left. Huge pages and the arena's node are only asked for; if the system
+ * cannot give them, the chunk is made of ordinary pages from any node.
+ */
+static struct chunk *newChunk(Allocator a, size_t size)
+{
+    if (!a->paged)
+    {
+        struct chunk *c = malloc(size);
+        if (c != NULL)
+        {
+            c->size = 0;
+        }
+        return c;
+    }
+
+    size_t pageSize = a->hugePages ? HUGE_PAGE_SIZE : PAGE_SIZE;
+    size = (size + pageSize - 1) / pageSize * pageSize;
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (a->hugePages)
+    {
+        madvise(p, size, MADV_HUGEPAGE);
+    }
+#endif
+    if (a->node >= 0)
+    {
+        NumaBindMemory(p, size, a->node);
+    }
+
+    struct chunk *c = p;
+    c->size = size;
+    return c;
+}
+
+/**
+ * Rounds the size up to a multiple of the alignment
+ */
+static size_t roundUp(size_t size)
+{
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
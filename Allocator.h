@@ -0,0 +1,107 @@
+// Interface to the Allocator ADT
+// An allocator hands out the memory that maps, agents, queues and games are
+// made of and keeps count of how much of it is in use. There are three
+// kinds:
+//  - a heap allocator gets every block from malloc and gives it back to free
+//  - an arena hands out blocks one after another from large chunks and
+//    gives all of them back at once when the arena is freed, so a game and
+//    its agents can be thrown away in one go. A paged arena gets its chunks
+//    from mmap, and can ask for them to be backed by huge pages and placed
+//    on a NUMA node.
+//  - an account gets its blocks from another allocator and counts them in
+//    its own totals as well, so that several subsystems can share one
+//    arena and still be measured separately
+// Wherever an allocator can be given, NULL means plain malloc and free with
+// no counting, which is what MapNew, AgentNew and QueueNew use.
+// Allocators can be used from several threads at once.
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct allocator *Allocator;
+
+/**
+ * Creates an allocator which gets every block from malloc
+ */
+Allocator AllocatorNewHeap(void);
+
+/**
+ * Creates an arena which gets its memory from malloc in chunks of at least
+ * `chunkSize` bytes. Releasing a block only takes it off the count; its
+ * memory is not used again until the arena is freed.
+ */
+Allocator AllocatorNewArena(size_t chunkSize);
+
+/**
+ * Creates an arena like AllocatorNewArena, but whose chunks come straight
+ * from mmap. With `hugePages`, chunks are rounded up to 2MB and backed by
+ * transparent huge pages where the system allows it, which saves TLB
+ * misses on large, randomly read arrays. With a `node` of 0 or more, their
+ * pages are placed on that NUMA node (see Numa.h) rather than wherever
+ * they are first touched; pass -1 for no node.
+ */
+Allocator AllocatorNewPagedArena(size_t chunkSize, int node, bool hugePages);
+
+/**
+ * Creates an account which gets its blocks from `parent`
+ * NOTE: The parent must outlive the account
+ */
+Allocator AllocatorNewAccount(Allocator parent);
+
+/**
+ * Frees the allocator. Freeing an arena frees every block it handed out;
+ * other allocators must have had all their blocks released first.
+ */
+void AllocatorFree(Allocator a);
+
+/**
+ * Makes any allocation that would take the bytes in use above `maxBytes`
+ * fail. Pass 0 for no limit (the default).
+ */
+void AllocatorSetLimit(Allocator a, size_t maxBytes);
+
+/**
+ * Returns a block of at least `size` bytes, aligned like malloc's, or NULL
+ * if there is no memory left or the allocator's limit would be passed
+ */
+void *AllocatorMalloc(Allocator a, size_t size);
+
+/**
+ * Like AllocatorMalloc, but for `numElements` elements of `size` bytes
+ * each, which are all set to zero
+ */
+void *AllocatorCalloc(Allocator a, size_t numElements, size_t size);
+
+/**
+ * Resizes a block from the same allocator, keeping its contents, and
+ * returns it (possibly moved), or returns NULL and leaves the block alone
+ * if it cannot. `p` may be NULL, as for realloc.
+ */
+void *AllocatorRealloc(Allocator a, void *p, size_t size);
+
+/**
+ * Returns a block to the allocator it came from. `p` may be NULL.
+ */
+void AllocatorRelease(Allocator a, void *p);
+
+/**
+ * Returns a copy of the string in a new block, or NULL if there is no
+ * memory left
+ */
+char *AllocatorStrdup(Allocator a, const char *s);
+
+/**
+ * Returns the number of bytes in the blocks the allocator has handed out
+ * and not had back
+ */
+size_t AllocatorBytesInUse(Allocator a);
+
+/**
+ * Returns the largest number of bytes the allocator has had in use at once
+ */
+size_t AllocatorPeakBytes(Allocator a);
+
+#endif
@@ -0,0 +1,191 @@
+// Implementation of the Fields ADT
+// The fields are kept in a list, each with the goal and maximum stamina it
+// was made for and the versions of the map it was made on. A field that is
+// out of date is made again in the same memory, so a field once handed out
+// stays where it is until the fields are freed. The list is searched and
+// fields are made under one lock; the map only changes between moves, so
+// a field handed out while moves are being worked out is not made again
+// until they have all been.
+
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Agent.h"
+#include "Allocator.h"
+#include "Fields.h"
+#include "LeastTurns.h"
+#include "Map.h"
+
+#define INFORMANTS -1 // the goal of the field towards the nearest informant
+
+struct field
+{
+    int goal; // a city, or INFORMANTS
+    int stamina;
+    unsigned long version;
+    unsigned long informantVersion; // only checked for INFORMANTS
+    struct costedMove *moves;
+    struct field *next;
+};
+
+struct fields
+{
+    Allocator allocator;
+    Map map;
+    struct field *first;
+    pthread_mutex_t lock;
+};
+
+static const struct costedMove *findField(Fields f, int goal, int stamina);
+static void makeField(Fields f, struct field *field);
+static void printNullError(void);
+
+/**
+ * Creates the fields with an empty list
+ */
+Fields FieldsNew(Map m, Allocator allocator)
+{
+    Fields f = AllocatorMalloc(allocator, sizeof(struct fields));
+    if (f == NULL)
+    {
+        printNullError();
+    }
+    f->allocator = allocator;
+    f->map = m;
+    f->first = NULL;
+    pthread_mutex_init(&f->lock, NULL);
+    return f;
+}
+
+/**
+ * Frees every field in the list and then the fields
+ */
+void FieldsFree(Fields f)
+{
+    struct field *field = f->first;
+    while (field != NULL)
+    {
+        struct field *next = field->next;
+        AllocatorRelease(f->allocator, field->moves);
+        AllocatorRelease(f->allocator, field);
+        field = next;
+    }
+    pthread_mutex_destroy(&f->lock);
+    AllocatorRelease(f->allocator, f);
+}
+
+/**
+ * Returns the field towards the informants
+ */
+const struct costedMove *FieldsToInformants(Fields f, int stamina)
+{
+    return findField(f, INFORMANTS, stamina);
+}
+
+/**
+ * Returns the field towards the city
+ */
+const struct costedMove *FieldsToCity(Fields f, int city, int stamina)
+{
+    assert(city >= 0 && city < MapNumCities(f->map));
+    return findField(f, city, stamina);
+}
+
+/**
+ * Looks the city up in the field towards the informants
+ */
+int FieldsTurnsToInformant(Fields f, int city, int stamina)
+{
+    assert(city >= 0 && city < MapNumCities(f->map));
+    int turns = FieldsToInformants(f, stamina)[city].numMovesTaken;
+    return turns == INT_MAX ? -1 : turns;
+}
+
+/**
+ * Returns the field with the given goal and stamina, adding it to the list
+ * if there is none and making it again if it is out of date
+ */
+static const struct costedMove *findField(Fields f, int goal, int stamina)
+{
+    pthread_mutex_lock(&f->lock);
+    struct field *field = f->first;
+    while (field != NULL &&
+           (field->goal != goal || field->stamina != stamina))
+    {
+        field = field->next;
+    }
+
+    if (field == NULL)
+    {
+        field = AllocatorMalloc(f->allocator, sizeof(struct field));
+        if (field == NULL)
+        {
+            printNullError();
+        }
+        field->moves = AllocatorMalloc(f->allocator, MapNumCities(f->map) *
+                                           sizeof(struct costedMove));
+        if (field->moves == NULL)
+        {
+            printNullError();
+        }
+        field->goal = goal;
+        field->stamina = stamina;
+        field->next = f->first;
+        f->first = field;
+        makeField(f, field);
+    }
+    else if (field->version != MapVersion(f->map) ||
+             (goal == INFORMANTS &&
+              field->informantVersion != MapInformantVersion(f->map)))
+    {
+        makeField(f, field);
+    }
+    pthread_mutex_unlock(&f->lock);
+    return field->moves;
+}
+
+/**
+ * Searches from the field's goal on the map as it is now
+ */
+static void makeField(Fields f, struct field *field)
+{
+    Map m = f->map;
+    field->version = MapVersion(m);
+    field->informantVersion = MapInformantVersion(m);
+    if (field->goal != INFORMANTS)
+    {
+        LeastTurnsSearch(m, field->goal, field->stamina, field->stamina,
+                         field->moves);
+        return;
+    }
+
+    int *informants = malloc((MapNumInformants(m) + 1) * sizeof(int));
+    if (informants == NULL)
+    {
+        printNullError();
+    }
+    int numInformants = 0;
+    for (int city = 0; city < MapNumCities(m); city++)
+    {
+        if (MapHasInformant(m, city))
+        {
+            informants[numInformants++] = city;
+        }
+    }
+    LeastTurnsMultiSearch(m, informants, numInformants, field->stamina,
+                          field->moves);
+    free(informants);
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,61 @@
+// Interface to the Fields ADT
+// A field is a least turns search towards a goal, which gives the next road
+// towards it from every city: the search from every informant city at once,
+// which INFORMANT_SEEKING detectives follow to the nearest informant, or the
+// search from one city, which a GETAWAY_SEEKING thief follows to its getaway
+// city. Fields holds the fields of one map for every maximum stamina they
+// have been asked for, so agents with the same maximum stamina share one
+// search, and makes a field again only once the roads it was made from (or,
+// for the informants' field, the informants) have changed.
+// Fields can be asked for from several threads at once.
+
+#ifndef FIELDS_H
+#define FIELDS_H
+
+#include "Agent.h"
+#include "Allocator.h"
+#include "LeastTurns.h"
+#include "Map.h"
+
+// The Fields type is declared in Agent.h
+
+/**
+ * Creates fields for the given map, holding none yet. Their memory comes
+ * from the given allocator, or from malloc if it is NULL.
+ * NOTE: The map and the allocator must outlive the fields
+ */
+Fields FieldsNew(Map m, Allocator allocator);
+
+/**
+ * Frees all memory allocated to the fields
+ */
+void FieldsFree(Fields f);
+
+/**
+ * Returns the search from every informant city at once for agents with the
+ * given maximum stamina, making it first if there is none for the map's
+ * current roads and informants. Following a city's path backwards leads to
+ * the nearest informant, and its `numMovesTaken` is the number of turns it
+ * takes to get there.
+ * NOTE: The field belongs to the fields and is only up to date until the
+ *       map next changes
+ */
+const struct costedMove *FieldsToInformants(Fields f, int stamina);
+
+/**
+ * Returns the search from the given city for agents with the given maximum
+ * stamina, making it first if there is none for the map's current roads.
+ * Following a city's path backwards leads to the given city.
+ * NOTE: The field belongs to the fields and is only up to date until the
+ *       map next changes
+ */
+const struct costedMove *FieldsToCity(Fields f, int city, int stamina);
+
+/**
+ * Returns the number of turns an agent with the given maximum stamina takes
+ * to get from the city to the nearest informant, or -1 if it cannot reach
+ * one
+ */
+int FieldsTurnsToInformant(Fields f, int city, int stamina);
+
+#endif
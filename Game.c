@@ -0,0 +1,723 @@
+// Implementation of the Game ADT
+// Every cycle, each agent's next move is worked out (one after another or
+// all at once on a pool) before any of the moves are made, then the game
+// checks whether the thief has been caught or has escaped, and finally
+// detectives on informant cities are tipped off about where the thief is.
+// Detectives using the COORDINATED strategy belong to a team, which plans
+// all of their moves before the moves are worked out and hears about every
+// tip-off.
+//
+// The game keeps an index of which agents are in every city, updated as
+// each move is made, so that capture checks and tip-offs only look at the
+// cities that matter instead of at every detective.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Agent.h"
+#include "Allocator.h"
+#include "Fields.h"
+#include "Game.h"
+#include "Loader.h"
+#include "LtpTable.h"
+#include "Map.h"
+#include "Pool.h"
+#include "Team.h"
+#include "Trace.h"
+#include "Visits.h"
+
+#define THIEF 0
+
+struct game
+{
+    Allocator allocator; // for the game and its agents
+    Map map;
+    int getaway;
+    int maxCycles;
+    int cycle;
+    int state;
+
+    Agent *agents; // the thief followed by the detectives
+    int numAgents;
+    struct move *moves;
+
+    Team team; // of the COORDINATED detectives, or NULL if there are none
+    Visits visits; // shared by the detectives, or NULL if each has its own
+    Fields fields; // followed by every agent heading for a goal or informant
+
+    Trace trace;
+    bool batchTipOffs;
+    Agent *tippedOff; // detectives being tipped off this cycle
+
+    Pool pool; // works out the moves if not NULL
+    struct moveTask *moveTasks;
+
+    // Occupancy index: the agents in each city form a doubly linked list,
+    // and the detectives standing on informant cities are kept in an array
+    // (informedIndex[agent] is the agent's position in it, or -1). The array
+    // is made again if the map's informants have changed since
+    // informedVersion, since one may have been added or removed under a
+    // detective.
+    int *numDetectivesAt;
+    int *firstAgentAt;
+    int *nextAgentAt;
+    int *prevAgentAt;
+    int *informed;
+    int *informedIndex;
+    int numInformed;
+    unsigned long informedVersion;
+};
+
+// A task that works out one agent's next move on a pool
+struct moveTask
+{
+    Agent agent;
+    Map map;
+    struct move *move;
+};
+
+static void printNullError(void);
+
+static Agent newAgent(Game g, struct agentData *data, int strategy,
+                      unsigned int seed);
+static void newIndex(Game g);
+static void findInformed(Game g);
+static void newTeam(Game g, struct gameData *data);
+static void addToIndex(Game g, int agent, int city);
+static void removeFromIndex(Game g, int agent, int city);
+static int compareInts(const void *a, const void *b);
+static void getNextMoves(Game g);
+static void getNextMove(void *arg);
+static void checkCaught(Game g);
+static void checkEscaped(Game g);
+static void tipOff(Game g);
+static void traceEvent(Game g, int agent, struct move move, int from,
+                       int event);
+
+/**
+ * Creates a game whose memory comes from malloc
+ */
+Game GameNew(Map m, struct gameData *data, int maxCycles, unsigned int seed)
+{
+    return GameNewWithAllocator(m, data, maxCycles, seed, NULL);
+}
+
+/**
+ * Creates the agents, then checks whether a detective starts in the thief's
+ * city and tips off detectives who start in an informant's city
+ */
+Game GameNewWithAllocator(Map m, struct gameData *data, int maxCycles,
+                          unsigned int seed, Allocator allocator)
+{
+    Game g = AllocatorMalloc(allocator, sizeof(struct game));
+    if (g == NULL)
+    {
+        printNullError();
+    }
+    g->allocator = allocator;
+    g->map = m;
+    g->getaway = data->getaway;
+    g->maxCycles = maxCycles;
+    g->cycle = 0;
+    g->state = GAME_RUNNING;
+
+    g->numAgents = data->numDetectives + 1;
+    g->agents = AllocatorMalloc(allocator, g->numAgents * sizeof(Agent));
+    g->moves = AllocatorMalloc(allocator, g->numAgents * sizeof(struct move));
+    g->tippedOff = AllocatorMalloc(allocator, g->numAgents * sizeof(Agent));
+    g->moveTasks = AllocatorMalloc(allocator,
+                                   g->numAgents * sizeof(struct moveTask));
+    if (g->agents == NULL || g->moves == NULL || g->tippedOff == NULL ||
+        g->moveTasks == NULL)
+    {
+        printNullError();
+    }
+    g->fields = FieldsNew(m, allocator);
+    g->agents[THIEF] = newAgent(g, &data->thief, data->thief.strategy, seed);
+    AgentSetGoal(g->agents[THIEF], data->getaway);
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        // spread the seeds out so that no two agents share a sequence
+        g->agents[i] = newAgent(g, &data->detectives[i - 1],
+                                data->detectives[i - 1].strategy,
+                                seed + i * 0x9E3779B9u);
+    }
+    newIndex(g);
+    newTeam(g, data);
+
+    g->visits = NULL;
+    g->trace = NULL;
+    g->batchTipOffs = false;
+    g->pool = NULL;
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        g->moveTasks[i] = (struct moveTask){g->agents[i], m, &g->moves[i]};
+    }
+
+    checkCaught(g);
+    if (g->state == GAME_RUNNING)
+    {
+        tipOff(g);
+    }
+    return g;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Creates the occupancy index and adds every agent to it
+ */
+static void newIndex(Game g)
+{
+    int numCities = MapNumCities(g->map);
+    Allocator a = g->allocator;
+    g->numDetectivesAt = AllocatorCalloc(a, numCities, sizeof(int));
+    g->firstAgentAt = AllocatorMalloc(a, numCities * sizeof(int));
+    g->nextAgentAt = AllocatorMalloc(a, g->numAgents * sizeof(int));
+    g->prevAgentAt = AllocatorMalloc(a, g->numAgents * sizeof(int));
+    g->informed = AllocatorMalloc(a, g->numAgents * sizeof(int));
+    g->informedIndex = AllocatorMalloc(a, g->numAgents * sizeof(int));
+    if (g->numDetectivesAt == NULL || g->firstAgentAt == NULL ||
+        g->nextAgentAt == NULL || g->prevAgentAt == NULL ||
+        g->informed == NULL || g->informedIndex == NULL)
+    {
+        printNullError();
+    }
+
+    for (int city = 0; city < numCities; city++)
+    {
+        g->firstAgentAt[city] = -1;
+    }
+    g->numInformed = 0;
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        g->informedIndex[i] = -1;
+        addToIndex(g, i, AgentLocation(g->agents[i]));
+    }
+    g->informedVersion = MapInformantVersion(g->map);
+}
+
+/**
+ * Makes the array of detectives standing on informant cities again from
+ * their locations
+ */
+static void findInformed(Game g)
+{
+    g->numInformed = 0;
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        g->informedIndex[i] = -1;
+        if (MapHasInformant(g->map, AgentLocation(g->agents[i])))
+        {
+            g->informedIndex[i] = g->numInformed;
+            g->informed[g->numInformed++] = i;
+        }
+    }
+    g->informedVersion = MapInformantVersion(g->map);
+}
+
+/**
+ * Adds an agent who has arrived in a city to the index
+ */
+static void addToIndex(Game g, int agent, int city)
+{
+    g->prevAgentAt[agent] = -1;
+    g->nextAgentAt[agent] = g->firstAgentAt[city];
+    if (g->firstAgentAt[city] != -1)
+    {
+        g->prevAgentAt[g->firstAgentAt[city]] = agent;
+    }
+    g->firstAgentAt[city] = agent;
+
+    if (agent != THIEF)
+    {
+        g->numDetectivesAt[city]++;
+        if (MapHasInformant(g->map, city))
+        {
+            g->informedIndex[agent] = g->numInformed;
+            g->informed[g->numInformed++] = agent;
+        }
+    }
+}
+
+/**
+ * Removes an agent who has left a city from the index
+ */
+static void removeFromIndex(Game g, int agent, int city)
+{
+    if (g->prevAgentAt[agent] != -1)
+    {
+        g->nextAgentAt[g->prevAgentAt[agent]] = g->nextAgentAt[agent];
+    }
+    else
+    {
+        g->firstAgentAt[city] = g->nextAgentAt[agent];
+    }
+    if (g->nextAgentAt[agent] != -1)
+    {
+        g->prevAgentAt[g->nextAgentAt[agent]] = g->prevAgentAt[agent];
+    }
+
+    if (agent != THIEF)
+    {
+        g->numDetectivesAt[city]--;
+        if (g->informedIndex[agent] != -1)
+        {
+            // move the last informed detective into the gap
+            int last = g->informed[--g->numInformed];
+            g->informed[g->informedIndex[agent]] = last;
+            g->informedIndex[last] = g->informedIndex[agent];
+            g->informedIndex[agent] = -1;
+        }
+    }
+}
+
+/**
+ * Creates an agent from its data with its own random number generator and
+ * the game's fields
+ */
+static Agent newAgent(Game g, struct agentData *data, int strategy,
+                      unsigned int seed)
+{
+    Agent agent = AgentNewWithAllocator(data->start, data->stamina, strategy,
+                                        g->map, data->name, g->allocator);
+    AgentSeed(agent, seed);
+    AgentSetFields(agent, g->fields);
+    return agent;
+}
+
+/**
+ * Puts the detectives using the COORDINATED strategy in a team, if there
+ * are any
+ */
+static void newTeam(Game g, struct gameData *data)
+{
+    g->team = NULL;
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        if (data->detectives[i - 1].strategy == COORDINATED)
+        {
+            if (g->team == NULL)
+            {
+                g->team = TeamNew(g->map, g->allocator);
+            }
+            TeamAddMember(g->team, g->agents[i]);
+        }
+    }
+}
+
+/**
+ * Frees the agents and the game
+ * NOTE: The map belongs to the caller
+ */
+void GameFree(Game g)
+{
+    if (g->team != NULL)
+    {
+        TeamFree(g->team);
+    }
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        AgentFree(g->agents[i]);
+    }
+    if (g->visits != NULL)
+    {
+        VisitsFree(g->visits);
+    }
+    FieldsFree(g->fields);
+    AllocatorRelease(g->allocator, g->agents);
+    AllocatorRelease(g->allocator, g->moves);
+    AllocatorRelease(g->allocator, g->tippedOff);
+    AllocatorRelease(g->allocator, g->moveTasks);
+    AllocatorRelease(g->allocator, g->numDetectivesAt);
+    AllocatorRelease(g->allocator, g->firstAgentAt);
+    AllocatorRelease(g->allocator, g->nextAgentAt);
+    AllocatorRelease(g->allocator, g->prevAgentAt);
+    AllocatorRelease(g->allocator, g->informed);
+    AllocatorRelease(g->allocator, g->informedIndex);
+    AllocatorRelease(g->allocator, g);
+}
+
+/**
+ * Sets the trace that moves are recorded in
+ */
+void GameSetTrace(Game g, Trace t)
+{
+    g->trace = t;
+}
+
+/**
+ * Sets whether tip-offs are batched
+ */
+void GameSetBatchTipOffs(Game g, bool batch)
+{
+    g->batchTipOffs = batch;
+}
+
+/**
+ * Sets the engine of every agent
+ */
+void GameSetEngine(Game g, int engine)
+{
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        AgentSetEngine(g->agents[i], engine);
+    }
+}
+
+/**
+ * Gives the table to the detectives with the table's maximum stamina
+ */
+void GameSetLtpTable(Game g, LtpTable t)
+{
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        // detectives with a different maximum stamina turn the table down
+        AgentSetLtpTable(g->agents[i], t);
+    }
+}
+
+/**
+ * Gives the landmarks to the detectives
+ */
+void GameSetLandmarks(Game g, Landmarks l)
+{
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        AgentSetLandmarks(g->agents[i], l);
+    }
+}
+
+/**
+ * Gives the budget to the detectives
+ */
+void GameSetPlanningBudget(Game g, long maxCities)
+{
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        AgentSetPlanningBudget(g->agents[i], maxCities);
+    }
+}
+
+/**
+ * Sets the search settings of the team
+ */
+void GameSetTeamSearch(Game g, int depth, size_t tableBytes, long maxNodes)
+{
+    if (g->team != NULL)
+    {
+        TeamSetSearch(g->team, depth, tableBytes, maxNodes);
+    }
+}
+
+/**
+ * Sets the pool that works out the moves
+ */
+void GameSetPool(Game g, Pool p)
+{
+    g->pool = p;
+}
+
+/**
+ * Makes shared visit counts and gives them to the detectives, or takes
+ * them back and frees them
+ */
+void GameSetSharedVisits(Game g, bool shared)
+{
+    if (shared && g->visits == NULL)
+    {
+        g->visits = VisitsNew(MapNumCities(g->map), g->allocator);
+    }
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        AgentSetVisits(g->agents[i], shared ? g->visits : NULL);
+    }
+    if (!shared && g->visits != NULL)
+    {
+        VisitsFree(g->visits);
+        g->visits = NULL;
+    }
+}
+
+/**
+ * Gives the search pool to the detectives
+ */
+void GameSetSearchPool(Game g, Pool p)
+{
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        AgentSetSearchPool(g->agents[i], p);
+    }
+}
+
+/**
+ * Works out every agent's move, makes the moves and then updates the state
+ * of the game
+ */
+int GameStep(Game g)
+{
+    if (g->state != GAME_RUNNING)
+    {
+        return g->state;
+    }
+
+    g->cycle++;
+    getNextMoves(g);
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        int from = AgentLocation(g->agents[i]);
+        AgentMakeNextMove(g->agents[i], g->moves[i]);
+        if (g->moves[i].to != from)
+        {
+            removeFromIndex(g, i, from);
+            addToIndex(g, i, g->moves[i].to);
+        }
+        traceEvent(g, i, g->moves[i], from,
+                   g->moves[i].to == from ? TRACE_REST : TRACE_MOVE);
+    }
+
+    checkCaught(g);
+    checkEscaped(g);
+    if (g->state == GAME_RUNNING)
+    {
+        tipOff(g);
+        if (g->cycle >= g->maxCycles)
+        {
+            g->state = GAME_COLD;
+        }
+    }
+
+    if (g->state != GAME_RUNNING)
+    {
+        int event = g->state == GAME_CAUGHT  ? TRACE_CAUGHT
+                  : g->state == GAME_ESCAPED ? TRACE_ESCAPED
+                                             : TRACE_COLD;
+        int thiefLocation = AgentLocation(g->agents[THIEF]);
+        traceEvent(g, THIEF, (struct move){thiefLocation, 0}, thiefLocation,
+                   event);
+    }
+    return g->state;
+}
+
+/**
+ * Plays cycles until the game is over
+ */
+int GameRun(Game g)
+{
+    while (g->state == GAME_RUNNING)
+    {
+        GameStep(g);
+    }
+    return g->state;
+}
+
+/**
+ * Returns the state of the game
+ */
+int GameState(Game g)
+{
+    return g->state;
+}
+
+/**
+ * Returns the number of cycles played
+ */
+int GameCycle(Game g)
+{
+    return g->cycle;
+}
+
+/**
+ * Adds up the detectives' budget hits
+ */
+long GameNumBudgetHits(Game g)
+{
+    long numHits = 0;
+    for (int i = 1; i < g->numAgents; i++)
+    {
+        numHits += AgentNumBudgetHits(g->agents[i]);
+    }
+    return numHits;
+}
+
+/**
+ * Returns the team
+ */
+Team GameTeam(Game g)
+{
+    return g->team;
+}
+
+/**
+ * Returns the number of agents including the thief
+ */
+int GameNumAgents(Game g)
+{
+    return g->numAgents;
+}
+
+/**
+ * Returns the given agent
+ */
+Agent GameAgent(Game g, int agent)
+{
+    assert(agent >= 0 && agent < g->numAgents);
+    return g->agents[agent];
+}
+
+/**
+ * Returns the agent most recently arrived in the city, or -1
+ */
+int GameFirstAgentAt(Game g, int city)
+{
+    assert(city >= 0 && city < MapNumCities(g->map));
+    return g->firstAgentAt[city];
+}
+
+/**
+ * Returns the agent after the given one in the same city, or -1
+ */
+int GameNextAgentAt(Game g, int agent)
+{
+    assert(agent >= 0 && agent < g->numAgents);
+    return g->nextAgentAt[agent];
+}
+
+/**
+ * Works out every agent's next move into g->moves. Working out a move only
+ * reads the map and changes the agent itself, so the agents can be worked
+ * out in any order or at the same time.
+ */
+static void getNextMoves(Game g)
+{
+    // the team's plan is made first, as the members' moves come from it
+    if (g->team != NULL)
+    {
+        TeamPlan(g->team);
+    }
+
+    if (g->pool == NULL)
+    {
+        for (int i = 0; i < g->numAgents; i++)
+        {
+            g->moves[i] = AgentGetNextMove(g->agents[i], g->map);
+        }
+        return;
+    }
+
+    for (int i = 0; i < g->numAgents; i++)
+    {
+        PoolSubmit(g->pool, getNextMove, &g->moveTasks[i]);
+    }
+    PoolWait(g->pool);
+}
+
+/**
+ * Pool task that works out one agent's next move
+ */
+static void getNextMove(void *arg)
+{
+    struct moveTask *task = arg;
+    *task->move = AgentGetNextMove(task->agent, task->map);
+}
+
+/**
+ * The thief is caught if any detective is in the thief's city
+ */
+static void checkCaught(Game g)
+{
+    int thiefLocation = AgentLocation(g->agents[THIEF]);
+    if (g->numDetectivesAt[thiefLocation] > 0)
+    {
+        g->state = GAME_CAUGHT;
+    }
+}
+
+/**
+ * The thief escapes if it reaches the getaway city without being caught
+ */
+static void checkEscaped(Game g)
+{
+    if (g->state == GAME_RUNNING &&
+        AgentLocation(g->agents[THIEF]) == g->getaway)
+    {
+        g->state = GAME_ESCAPED;
+    }
+}
+
+/**
+ * Tells every detective in an informant's city where the thief is
+ */
+static void tipOff(Game g)
+{
+    int thiefLocation = AgentLocation(g->agents[THIEF]);
+    if (MapInformantVersion(g->map) != g->informedVersion)
+    {
+        findInformed(g);
+    }
+
+    // tip the detectives off in the order they were given
+    qsort(g->informed, g->numInformed, sizeof(int), compareInts);
+    for (int i = 0; i < g->numInformed; i++)
+    {
+        g->informedIndex[g->informed[i]] = i;
+    }
+
+    int numTippedOff = 0;
+    for (int i = 0; i < g->numInformed; i++)
+    {
+        int agent = g->informed[i];
+        int location = AgentLocation(g->agents[agent]);
+        g->tippedOff[numTippedOff++] = g->agents[agent];
+        traceEvent(g, agent, (struct move){location, 0}, location,
+                   TRACE_TIP_OFF);
+    }
+
+    if (g->team != NULL && numTippedOff > 0)
+    {
+        TeamSighting(g->team, thiefLocation);
+    }
+    if (g->batchTipOffs && numTippedOff > 0)
+    {
+        AgentTipOffAll(g->tippedOff, numTippedOff, thiefLocation, g->map);
+        return;
+    }
+    for (int i = 0; i < numTippedOff; i++)
+    {
+        AgentTipOff(g->tippedOff[i], thiefLocation);
+    }
+}
+
+/**
+ * Comparison function used by qsort that sorts ints in ascending order
+ */
+static int compareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Adds a record to the game's trace if it has one
+ */
+static void traceEvent(Game g, int agent, struct move move, int from,
+                       int event)
+{
+    if (g->trace != NULL)
+    {
+        TraceWrite(g->trace, (struct traceRecord){
+            g->cycle, agent, from, move.to, move.staminaCost,
+            AgentStamina(g->agents[agent]), event});
+    }
+}
+
@@ -0,0 +1,183 @@
+// Interface to the Game ADT
+// A game is one thief and the detectives moving around a map until the
+// thief is caught, escapes or the time runs out, following the rules in
+// README.md. The map is only read, so many games can share one map.
+
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+
+#include "Agent.h"
+#include "Loader.h"
+#include "Map.h"
+#include "Pool.h"
+#include "Team.h"
+#include "Trace.h"
+
+// Constants to represent the state of a game
+#define GAME_RUNNING    0
+#define GAME_CAUGHT     1 // the detectives win
+#define GAME_ESCAPED    2 // the thief reached the getaway city
+#define GAME_COLD       3 // the time ran out
+
+typedef struct game *Game;
+
+/**
+ * Creates a new game with the agents described by `data` on the given map,
+ * with any number of detectives. A thief using the GETAWAY_SEEKING strategy
+ * heads for the getaway city, and detectives are tipped off in the map's
+ * informant cities. Every agent gets its own random number generator
+ * derived from `seed`, so the same seed always plays out the same game.
+ * NOTE: The map is owned by the caller and must outlive the game
+ */
+Game GameNew(Map m, struct gameData *data, int maxCycles, unsigned int seed);
+
+/**
+ * Like GameNew, but the game and its agents get their memory from the given
+ * allocator, or from malloc if it is NULL. With an arena, the whole game can
+ * be thrown away by freeing the arena after GameFree.
+ * NOTE: The allocator must outlive the game
+ */
+Game GameNewWithAllocator(Map m, struct gameData *data, int maxCycles,
+                          unsigned int seed, Allocator allocator);
+
+/**
+ * Frees all memory allocated to the game, including its agents
+ */
+void GameFree(Game g);
+
+/**
+ * Records every move made from now on in the given trace
+ */
+void GameSetTrace(Game g, Trace t);
+
+/**
+ * Makes detectives who are tipped off in the same cycle share their least
+ * turns searches (see AgentTipOffAll)
+ */
+void GameSetBatchTipOffs(Game g, bool batch);
+
+/**
+ * Sets the engine every agent uses to work out its moves (see AgentSetEngine)
+ */
+void GameSetEngine(Game g, int engine);
+
+/**
+ * Gives the table to every detective whose maximum stamina it was built for
+ * (see AgentSetLtpTable). Detectives only follow tables when tip-offs are
+ * batched.
+ * NOTE: The table is owned by the caller and must outlive the game
+ */
+void GameSetLtpTable(Game g, LtpTable t);
+
+/**
+ * Gives the landmarks to every detective (see AgentSetLandmarks)
+ * NOTE: The landmarks are owned by the caller and must outlive the game
+ */
+void GameSetLandmarks(Game g, Landmarks l);
+
+/**
+ * Gives every detective a planning budget of `maxCities` cities per move
+ * (see AgentSetPlanningBudget). Detectives only plan within the budget when
+ * tip-offs are not batched.
+ */
+void GameSetPlanningBudget(Game g, long maxCities);
+
+/**
+ * Sets how far ahead and how hard the detectives using the COORDINATED
+ * strategy search when planning their moves together (see TeamSetSearch).
+ * Does nothing if no detective uses it.
+ */
+void GameSetTeamSearch(Game g, int depth, size_t tableBytes, long maxNodes);
+
+/**
+ * Works out the agents' moves for every cycle concurrently on the given
+ * pool, then makes them one after another in the usual order, so the game
+ * plays out exactly as it would without the pool. Pass NULL to work the
+ * moves out on the calling thread again.
+ * NOTE: GameStep waits for the pool to be idle, so the pool must not be
+ *       shared with other work, including the task that is playing the game
+ */
+void GameSetPool(Game g, Pool p);
+
+/**
+ * Makes the detectives count their visits in one set of counts shared by
+ * all of them (see AgentSetVisits), or each in its own again. Detectives
+ * using the CHEAPEST_LEAST_VISITED strategy then head for the cities the
+ * detectives together have visited least, and the counts take the memory
+ * of one detective's. The thief always keeps its own counts. Visits are
+ * only added to the shared counts as moves are made, so a pool (see
+ * GameSetPool) does not change the game.
+ */
+void GameSetSharedVisits(Game g, bool shared);
+
+/**
+ * Gives every detective a pool to run its least turns searches on (see
+ * AgentSetSearchPool). Pass NULL to search on the calling threads again.
+ * NOTE: The pool is owned by the caller and must outlive the game. It must
+ *       not be the pool given to GameSetPool.
+ */
+void GameSetSearchPool(Game g, Pool p);
+
+/**
+ * Plays one cycle of the game and returns the state of the game after it
+ * Does nothing if the game is already over
+ */
+int GameStep(Game g);
+
+/**
+ * Plays the game until it is over and returns how it finished
+ */
+int GameRun(Game g);
+
+/**
+ * Returns the state of the game
+ */
+int GameState(Game g);
+
+/**
+ * Returns the number of cycles that have been played
+ */
+int GameCycle(Game g);
+
+/**
+ * Returns the number of moves so far on which a detective's planning budget
+ * ran out before its search finished
+ */
+long GameNumBudgetHits(Game g);
+
+/**
+ * Returns the number of agents in the game. Agent 0 is the thief and the
+ * rest are the detectives in the order they were given.
+ */
+int GameNumAgents(Game g);
+
+/**
+ * Returns the given agent
+ */
+Agent GameAgent(Game g, int agent);
+
+/**
+ * Returns the team of the detectives using the COORDINATED strategy, which
+ * plans their moves, or NULL if no detective uses it
+ */
+Team GameTeam(Game g);
+
+/**
+ * Returns the first agent in the given city, or -1 if there is none. The
+ * rest of the agents in the city follow from GameNextAgentAt, so listing a
+ * city takes time in proportion to the agents in it:
+ *     for (int a = GameFirstAgentAt(g, city); a != -1;
+ *          a = GameNextAgentAt(g, a))
+ */
+int GameFirstAgentAt(Game g, int city);
+
+/**
+ * Returns the next agent in the same city as the given agent, or -1 if it
+ * is the last one
+ */
+int GameNextAgentAt(Game g, int agent);
+
+#endif
+
@@ -0,0 +1,213 @@
+// Implementation of the HubTree ADT
+// The tree is a tournament tree stored in an array: the leaves are the
+// roads, padded with empty leaves up to a power of two, and every internal
+// node holds the winner of its two children. One road beats another if its
+// city has fewer visits or, on a tie, if it comes first. The roads are
+// sorted by length and then by city ID, so coming first is the same as
+// being shorter or having the lower ID.
+//
+// The roads are also kept sorted by city ID with their positions, so that
+// the leaf for a city can be found by binary search when its visits change.
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "HubTree.h"
+#include "Map.h"
+
+#define EMPTY -1
+
+struct neighbour
+{
+    int city;
+    int position; // of the road to the city
+};
+
+struct hubTree
+{
+    struct road *roads;
+    int numRoads;
+    int *visits;
+
+    int numLeaves;  // a power of two
+    int *winners;   // [1, 2 * numLeaves), with the leaves at the end
+    struct neighbour *byCity;
+};
+
+static void printNullError(void);
+static int winner(HubTree t, int a, int b);
+static int compareNeighbours(const void *a, const void *b);
+
+/**
+ * Copies the roads, then fills in the leaves and every internal node from
+ * the bottom up
+ */
+HubTree HubTreeNew(Map m, int city, int *visits)
+{
+    HubTree t = malloc(sizeof(struct hubTree));
+    if (t == NULL)
+    {
+        printNullError();
+    }
+    int numRoads = MapNumRoadsFrom(m, city);
+    t->roads = malloc((numRoads + 1) * sizeof(struct road));
+    if (t->roads == NULL)
+    {
+        printNullError();
+    }
+    MapGetRoadsByLength(m, city, INT_MAX, t->roads);
+    const struct road *roads = t->roads;
+    t->numRoads = numRoads;
+    t->visits = visits;
+    t->numLeaves = 1;
+    while (t->numLeaves < numRoads)
+    {
+        t->numLeaves *= 2;
+    }
+
+    t->winners = malloc(2 * t->numLeaves * sizeof(int));
+    t->byCity = malloc((numRoads + 1) * sizeof(struct neighbour));
+    if (t->winners == NULL || t->byCity == NULL)
+    {
+        printNullError();
+    }
+    for (int i = 0; i < t->numLeaves; i++)
+    {
+        t->winners[t->numLeaves + i] = i < numRoads ? i : EMPTY;
+    }
+    for (int node = t->numLeaves - 1; node > 0; node--)
+    {
+        t->winners[node] = winner(t, t->winners[2 * node],
+                                  t->winners[2 * node + 1]);
+    }
+
+    for (int i = 0; i < numRoads; i++)
+    {
+        t->byCity[i] = (struct neighbour){roads[i].to, i};
+    }
+    qsort(t->byCity, numRoads, sizeof(struct neighbour), compareNeighbours);
+    return t;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Frees the roads, the nodes, the roads sorted by city and the tree
+ */
+void HubTreeFree(HubTree t)
+{
+    free(t->roads);
+    free(t->winners);
+    free(t->byCity);
+    free(t);
+}
+
+/**
+ * Finds the city's leaf and replays the matches on the way up to the root
+ */
+void HubTreeUpdate(HubTree t, int city)
+{
+    int low = 0;
+    int high = t->numRoads - 1;
+    while (low <= high)
+    {
+        int mid = low + (high - low) / 2;
+        if (t->byCity[mid].city == city)
+        {
+            int node = (t->numLeaves + t->byCity[mid].position) / 2;
+            for (; node > 0; node /= 2)
+            {
+                t->winners[node] = winner(t, t->winners[2 * node],
+                                          t->winners[2 * node + 1]);
+            }
+            return;
+        }
+        else if (t->byCity[mid].city < city)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+}
+
+/**
+ * Finds the number of roads no longer than maxLength with a binary search,
+ * then combines the winners of the fewest nodes that exactly cover that
+ * many leaves
+ */
+const struct road *HubTreeLeastVisited(HubTree t, int maxLength)
+{
+    int low = 0;
+    int high = t->numRoads;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (t->roads[mid].length <= maxLength)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    int numRoads = low;
+
+    int best = EMPTY;
+    int left = t->numLeaves;
+    int right = t->numLeaves + numRoads;
+    while (left < right)
+    {
+        if (left % 2 == 1)
+        {
+            best = winner(t, best, t->winners[left++]);
+        }
+        if (right % 2 == 1)
+        {
+            best = winner(t, best, t->winners[--right]);
+        }
+        left /= 2;
+        right /= 2;
+    }
+    return best == EMPTY ? NULL : &t->roads[best];
+}
+
+/**
+ * Returns whichever of the two roads leads to the city with fewer visits,
+ * or the one that comes first if the visits are equal
+ */
+static int winner(HubTree t, int a, int b)
+{
+    if (a == EMPTY || b == EMPTY)
+    {
+        return a == EMPTY ? b : a;
+    }
+    int visitsA = t->visits[t->roads[a].to];
+    int visitsB = t->visits[t->roads[b].to];
+    if (visitsA != visitsB)
+    {
+        return visitsA < visitsB ? a : b;
+    }
+    return a < b ? a : b;
+}
+
+/**
+ * Comparison function used by qsort that sorts neighbours by ascending city
+ */
+static int compareNeighbours(const void *a, const void *b)
+{
+    const struct neighbour *x = a;
+    const struct neighbour *y = b;
+    return (x->city > y->city) - (x->city < y->city);
+}
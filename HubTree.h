@@ -0,0 +1,43 @@
+// Interface to the HubTree ADT
+// A hub tree picks the cheapest least visited road out of a city with many
+// roads without looking at all of them. It holds a copy of a city's roads in
+// the order of MapGetRoadsByLength, and the road an agent using the
+// CHEAPEST_LEAST_VISITED strategy would take from those no longer than any
+// length (the roads it can afford) is found in O(log n) time. When the
+// agent's visit count for a city changes, the tree is told about it with
+// HubTreeUpdate, which also takes O(log n) time.
+
+#ifndef HUB_TREE_H
+#define HUB_TREE_H
+
+#include "Map.h"
+
+typedef struct hubTree *HubTree;
+
+/**
+ * Creates a tree over the roads connected to the given city. `visits` is
+ * the agent's visit count for every city.
+ * NOTE: The visit counts belong to the caller and must outlive the tree.
+ *       The tree is out of date once the roads of the map change.
+ */
+HubTree HubTreeNew(Map m, int city, int *visits);
+
+/**
+ * Frees all memory allocated to the tree
+ */
+void HubTreeFree(HubTree t);
+
+/**
+ * Brings the tree up to date after the visit count of the given city has
+ * changed. Does nothing if none of the tree's roads lead to the city.
+ */
+void HubTreeUpdate(HubTree t, int city);
+
+/**
+ * Returns the road to the least visited city among the roads no longer
+ * than `maxLength`, with ties broken on the shortest road and then on the
+ * lowest city ID, or NULL if there are no such roads
+ */
+const struct road *HubTreeLeastVisited(HubTree t, int maxLength);
+
+#endif
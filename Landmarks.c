@@ -0,0 +1,251 @@
+// Implementation of the Landmarks ADT
+// The first landmark is the city farthest from city 0, and every later
+// landmark is the city whose distance to its nearest landmark is largest.
+// Distances are found with Dijkstra's algorithm on a binary heap which may
+// hold several entries for one city, of which only the smallest is used.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Agent.h"
+#include "Landmarks.h"
+#include "Map.h"
+
+#define UNREACHABLE -1
+
+struct landmarks
+{
+    int numCities;
+    int numLandmarks;
+    long *distances; // [landmark * numCities + city], or UNREACHABLE
+
+    // the map the landmarks are for and the version of its roads
+    Map map;
+    unsigned long mapVersion;
+};
+
+struct heapEntry
+{
+    long distance;
+    int city;
+};
+
+struct heap
+{
+    struct heapEntry *entries;
+    int numEntries;
+    int size;
+};
+
+static void printNullError(void);
+static int farthestCity(Landmarks l, long *nearest);
+static void shortestDistances(Map m, int source, long *distances);
+static void heapPush(struct heap *h, long distance, int city);
+static struct heapEntry heapPop(struct heap *h);
+
+/**
+ * Chooses each landmark from the distances to the ones before it
+ */
+Landmarks LandmarksNew(Map m, int numLandmarks)
+{
+    assert(numLandmarks > 0);
+
+    Landmarks l = malloc(sizeof(struct landmarks));
+    if (l == NULL)
+    {
+        printNullError();
+    }
+    l->numCities = MapNumCities(m);
+    l->numLandmarks = numLandmarks;
+    l->map = m;
+    l->mapVersion = MapVersion(m);
+    l->distances = malloc((size_t)numLandmarks * l->numCities * sizeof(long));
+
+    // the distance from every city to its nearest landmark so far
+    long *nearest = malloc(l->numCities * sizeof(long));
+    if (l->distances == NULL || nearest == NULL)
+    {
+        printNullError();
+    }
+
+    shortestDistances(m, 0, nearest);
+    for (int i = 0; i < numLandmarks; i++)
+    {
+        long *distances = &l->distances[(size_t)i * l->numCities];
+        shortestDistances(m, farthestCity(l, nearest), distances);
+        for (int city = 0; city < l->numCities; city++)
+        {
+            if (i == 0 || distances[city] < nearest[city])
+            {
+                nearest[city] = distances[city];
+            }
+        }
+    }
+
+    free(nearest);
+    return l;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Returns the reachable city that is farthest from its nearest landmark
+ */
+static int farthestCity(Landmarks l, long *nearest)
+{
+    int farthest = 0;
+    for (int city = 1; city < l->numCities; city++)
+    {
+        if (nearest[city] > nearest[farthest])
+        {
+            farthest = city;
+        }
+    }
+    return farthest;
+}
+
+/**
+ * Frees the distances and the landmarks
+ */
+void LandmarksFree(Landmarks l)
+{
+    free(l->distances);
+    free(l);
+}
+
+/**
+ * Checks that the landmarks are for this map and its roads are unchanged
+ */
+bool LandmarksIsCurrent(Landmarks l, Map m)
+{
+    return l->map == m && l->mapVersion == MapVersion(m);
+}
+
+/**
+ * Returns the largest difference between the two cities' distances to a
+ * landmark. A landmark which can reach one city but not the other shows
+ * that there is no path between them.
+ */
+long LandmarksLowerBound(Landmarks l, int city1, int city2)
+{
+    assert(city1 >= 0 && city1 < l->numCities);
+    assert(city2 >= 0 && city2 < l->numCities);
+
+    long bound = 0;
+    for (int i = 0; i < l->numLandmarks; i++)
+    {
+        long *distances = &l->distances[(size_t)i * l->numCities];
+        long d1 = distances[city1];
+        long d2 = distances[city2];
+        if ((d1 == UNREACHABLE) != (d2 == UNREACHABLE))
+        {
+            return UNREACHABLE;
+        }
+        long difference = d1 > d2 ? d1 - d2 : d2 - d1;
+        if (difference > bound)
+        {
+            bound = difference;
+        }
+    }
+    return bound;
+}
+
+/**
+ * Fills `distances` with the shortest road distance from the source to
+ * every city, or UNREACHABLE
+ */
+static void shortestDistances(Map m, int source, long *distances)
+{
+    for (int city = 0; city < MapNumCities(m); city++)
+    {
+        distances[city] = UNREACHABLE;
+    }
+
+    struct heap h = {NULL, 0, 0};
+    heapPush(&h, 0, source);
+    while (h.numEntries > 0)
+    {
+        struct heapEntry e = heapPop(&h);
+        if (distances[e.city] != UNREACHABLE)
+        {
+            continue; // already settled with a smaller distance
+        }
+        distances[e.city] = e.distance;
+
+        struct roadIterator it;
+        MapIterateRoads(m, e.city, &it);
+        struct road r;
+        while (MapNextRoad(&it, &r))
+        {
+            if (distances[r.to] == UNREACHABLE)
+            {
+                heapPush(&h, e.distance + r.length, r.to);
+            }
+        }
+    }
+    free(h.entries);
+}
+
+/**
+ * Adds an entry to the heap, growing it if it is full
+ */
+static void heapPush(struct heap *h, long distance, int city)
+{
+    if (h->numEntries == h->size)
+    {
+        h->size = h->size == 0 ? 64 : h->size * 2;
+        h->entries = realloc(h->entries, h->size * sizeof(struct heapEntry));
+        if (h->entries == NULL)
+        {
+            printNullError();
+        }
+    }
+
+    // sift the new entry up from the bottom of the heap
+    int i = h->numEntries++;
+    while (i > 0 && h->entries[(i - 1) / 2].distance > distance)
+    {
+        h->entries[i] = h->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->entries[i] = (struct heapEntry){distance, city};
+}
+
+/**
+ * Removes and returns the entry with the smallest distance
+ * Assumes that the heap is not empty
+ */
+static struct heapEntry heapPop(struct heap *h)
+{
+    struct heapEntry top = h->entries[0];
+    struct heapEntry last = h->entries[--h->numEntries];
+
+    // sift the last entry down from the top of the heap
+    int i = 0;
+    while (2 * i + 1 < h->numEntries)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < h->numEntries &&
+            h->entries[child + 1].distance < h->entries[child].distance)
+        {
+            child++;
+        }
+        if (h->entries[child].distance >= last.distance)
+        {
+            break;
+        }
+        h->entries[i] = h->entries[child];
+        i = child;
+    }
+    h->entries[i] = last;
+    return top;
+}
@@ -0,0 +1,45 @@
+// Interface to the Landmarks ADT
+// Landmarks are a few cities spread out across a map, with the shortest
+// road distance from each of them to every city. By the triangle
+// inequality, the distance between two cities is at least the difference
+// of their distances to any landmark, which gives a cheap lower bound on
+// how far apart any two cities are.
+//
+// Landmarks take one shortest path search per landmark to build and 8
+// bytes per landmark for every city.
+
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <stdbool.h>
+
+#include "Agent.h"
+#include "Map.h"
+
+// The Landmarks type is declared in Agent.h
+
+/**
+ * Chooses the given number of landmarks on the map, each as far as possible
+ * from the ones before it, and works out their distances to every city
+ * Assumes that `numLandmarks` is positive
+ */
+Landmarks LandmarksNew(Map m, int numLandmarks);
+
+/**
+ * Frees all memory allocated to the landmarks
+ */
+void LandmarksFree(Landmarks l);
+
+/**
+ * Returns true if the landmarks were built for the given map and its roads
+ * have not changed since
+ */
+bool LandmarksIsCurrent(Landmarks l, Map m);
+
+/**
+ * Returns a lower bound on the total length of the roads on any path
+ * between the two cities, or -1 if there is no such path
+ */
+long LandmarksLowerBound(Landmarks l, int city1, int city2);
+
+#endif
@@ -0,0 +1,986 @@
+// Implementation of the least turns search
+// Each city is labelled with the road it was reached by, the stamina left on
+// arrival and the number of turns taken. Cities are processed in the order
+// they are queued, trying their roads from shortest to longest, and a city is
+// queued again whenever its label improves or the agent has to rest there.
+//
+// The reference search is a separate copy of the search as it was first
+// written in Agent.c, which sorts each city's roads by length as it
+// processes the city, so the search above can be checked against it.
+//
+// A goal search labels cities in the same way, but does not queue a city
+// when its turns so far plus a lower bound on the turns left to the goal
+// come to more than the goal's label. Such a city can never lead to a
+// better or equally good label for the goal.
+//
+// A search from several cities labels all of them with no turns taken and
+// queues them in order, so every other city ends up labelled from the one
+// it can be reached from in the fewest turns.
+//
+// A partial search keeps its queue between calls and processes a limited
+// number of cities each time, in the same order as a search run in one go,
+// so once its queue is empty its labels are the same.
+//
+// A parallel search labels cities one number of turns at a time. The cities
+// first reached in t turns, along with those reached in t - 1 turns which
+// have to rest before taking some road, make up the frontier, and every
+// unlabelled city one road away from it is labelled with t + 1 turns and the
+// most stamina any frontier city leaves it with. Threads reaching the same
+// city agree on its label with an atomic maximum of the stamina and the
+// lowest predecessor, so the labels do not depend on timing. While the
+// frontier's roads are few, its cities are split between the threads
+// (top-down); once they outnumber a fraction of the unlabelled cities'
+// roads, the unlabelled cities are split between the threads instead and
+// each looks among its own roads for the frontier (bottom-up), which stops
+// the threads from trying roads to cities that are already labelled.
+
+// Acknowledgements:
+//  - ltpGetMoves and referenceGetMoves: The following code was adapted from
+//    the comp2521 2024T3 Graph Traversal slides.
+//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+//    This gets the moves for the bfs until the queue that holds all the cities
+//    that still needs to be accounted for is empty
+//  - referenceFillQueue: The following code was adapted from the comp2521
+//    2024T3 Graph Traversal slides.
+//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+//    Enqueues all the non-visited cities that is adjacent to the current city 
+//    into the queue.
+//  - Queue.h: The following interface was taken from the comp2521 2024T3 lab4 
+//    resources.
+//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/labs/week04/files/Queue.h
+//  - Queue.c: The following interface was taken from the comp2521 2024T3 lab4 
+//    resources.
+//    Link :https://cgi.cse.unsw.edu.au/~cs2521/24T3/labs/week04/files/Queue.c
+
+#include <assert.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Agent.h"
+#include "Landmarks.h"
+#include "LeastTurns.h"
+#include "Map.h"
+#include "Pool.h"
+#include "Queue.h"
+
+// A parallel search goes bottom-up once the frontier's roads number more
+// than the unlabelled cities' roads divided by this
+#define BOTTOM_UP_FACTOR 14
+// Levels with fewer cities than this to go through are not worth splitting
+#define MIN_CITIES_PER_TASK 1024
+#define TASKS_PER_THREAD 4
+// Cities each task labels before adding them to the shared list at once
+#define REACHED_BUFFER_SIZE 256
+
+// The city a goal search is heading for
+struct goal
+{
+    int city;
+    Landmarks landmarks;
+};
+
+struct partialSearch
+{
+    Map m;
+    int stamina;
+    struct costedMove *predecessor;
+    Queue q;
+};
+
+// The state of a parallel search shared by its tasks
+struct parallelSearch
+{
+    Map m;
+    int stamina;
+    struct costedMove *predecessor;
+    Pool pool;
+
+    // For every city reached in the level being searched: the largest
+    // (stamina left + 1) << 32 | ~predecessor offered so far, or 0
+    _Atomic uint64_t *best;
+    int *frontierStamina; // stamina a frontier city sets out with, or -1
+    bool *mustRest; // true if a labelled city has to rest for some road
+
+    int *frontier;
+    int frontierSize;
+    int *nextFrontier;
+    int *reached; // the cities labelled in the level being searched
+    atomic_int numReached;
+    int turns; // taken to reach the first-arrival cities on the frontier
+};
+
+// A range of the frontier, the cities or the reached cities for one task
+struct searchTask
+{
+    struct parallelSearch *s;
+    int first;
+    int last; // one past the end
+};
+
+// Cities reached by one task which have not been added to the shared list
+struct reachedBuffer
+{
+    int cities[REACHED_BUFFER_SIZE];
+    int numCities;
+};
+
+static void printNullError(void);
+static struct road *createRoads(Map m);
+
+static void search(Map m, int cities[], int numCities, int startStamina,
+                   int stamina, struct costedMove *predecessor,
+                   struct goal *goal);
+static Queue startSearch(Map m, int cities[], int numCities,
+                         int startStamina, struct costedMove *predecessor);
+static bool ltpGetMoves(Queue q, struct costedMove *predecessor, int stamina,
+                        Map m, struct goal *goal, long maxCities);
+static bool tryRoad(struct road road, Queue q, int currentCity,
+                    struct costedMove *predecessor, int stamina,
+                    struct goal *goal);
+static bool cannotReachGoal(struct goal *goal, struct costedMove *predecessor,
+                            int city, int stamina);
+static long minTurnsToGoal(struct goal *goal, int city, int remainingStamina,
+                           int stamina);
+static bool pathNeedsUpdating(struct road road, int currentCity,
+                              struct costedMove *predecessor);
+
+static void referenceSearch(Map m, int cities[], int numCities,
+                            int startStamina, int stamina,
+                            struct costedMove *predecessor);
+static void referenceGetMoves(Queue q, struct costedMove *predecessor,
+                              int stamina, Map m);
+static int compare(const void *a, const void *b);
+static void referenceFillQueue(struct road *roads, int roadSize, Queue q,
+                               int currentCity,
+                               struct costedMove *predecessor, int stamina);
+static bool referencePathNeedsUpdating(struct road *roads, int currentCity,
+                                       struct costedMove *predecessor,
+                                       int index);
+
+static long startParallelSearch(struct parallelSearch *s, int city,
+                               int startStamina, long *unlabelledRoads);
+static void runTasks(struct parallelSearch *s, PoolTask task, int size);
+static void searchTopDown(void *arg);
+static void searchBottomUp(void *arg);
+static void offerLabel(struct parallelSearch *s, int city, uint64_t key,
+                       struct reachedBuffer *buffer);
+static void addReached(struct parallelSearch *s, int city,
+                       struct reachedBuffer *buffer);
+static void flushReached(struct parallelSearch *s,
+                         struct reachedBuffer *buffer);
+static void labelReached(void *arg);
+static long nextLevel(struct parallelSearch *s, long *unlabelledRoads);
+static bool needsRest(Map m, int city, int remainingStamina, int stamina);
+static uint64_t labelKey(int remainingStamina, int from);
+
+/**
+ * Runs the search over the map's length-sorted roads
+ */
+void LeastTurnsSearch(Map m, int city, int startStamina, int stamina,
+                      struct costedMove *predecessor)
+{
+    search(m, &city, 1, startStamina, stamina, predecessor, NULL);
+}
+
+/**
+ * Runs the search one level of turns at a time, splitting each level
+ * between the pool's threads
+ */
+void LeastTurnsParallelSearch(Map m, int city, int startStamina, int stamina,
+                              struct costedMove *predecessor, Pool pool)
+{
+    int numCities = MapNumCities(m);
+    struct parallelSearch s = {.m = m, .stamina = stamina,
+                               .predecessor = predecessor, .pool = pool};
+    s.best = malloc(numCities * sizeof(_Atomic uint64_t));
+    s.frontierStamina = malloc(numCities * sizeof(int));
+    s.mustRest = malloc(numCities * sizeof(bool));
+    s.frontier = malloc(numCities * sizeof(int));
+    s.nextFrontier = malloc(numCities * sizeof(int));
+    s.reached = malloc(numCities * sizeof(int));
+    if (s.best == NULL || s.frontierStamina == NULL || s.mustRest == NULL ||
+        s.frontier == NULL || s.nextFrontier == NULL || s.reached == NULL)
+    {
+        printNullError();
+    }
+
+    long unlabelledRoads = 0;
+    long frontierRoads = startParallelSearch(&s, city, startStamina,
+                                             &unlabelledRoads);
+    while (s.frontierSize > 0)
+    {
+        atomic_store_explicit(&s.numReached, 0, memory_order_relaxed);
+        if (frontierRoads > unlabelledRoads / BOTTOM_UP_FACTOR)
+        {
+            runTasks(&s, searchBottomUp, numCities);
+        }
+        else
+        {
+            runTasks(&s, searchTopDown, s.frontierSize);
+        }
+        runTasks(&s, labelReached,
+                 atomic_load_explicit(&s.numReached, memory_order_relaxed));
+        frontierRoads = nextLevel(&s, &unlabelledRoads);
+        s.turns++;
+    }
+
+    // like LeastTurnsSearch, a city which has to rest for some road is left
+    // labelled as having rested
+    for (int i = 0; i < numCities; i++)
+    {
+        if (predecessor[i].numMovesTaken != INT_MAX && s.mustRest[i])
+        {
+            predecessor[i].remainingStamina = stamina;
+            predecessor[i].numMovesTaken++;
+        }
+    }
+
+    free(s.best);
+    free(s.frontierStamina);
+    free(s.mustRest);
+    free(s.frontier);
+    free(s.nextFrontier);
+    free(s.reached);
+}
+
+/**
+ * Runs the reference search from the one city
+ */
+void LeastTurnsReferenceSearch(Map m, int city, int startStamina, int stamina,
+                               struct costedMove *predecessor)
+{
+    referenceSearch(m, &city, 1, startStamina, stamina, predecessor);
+}
+
+/**
+ * Runs the search over the map's length-sorted roads towards the goal
+ */
+void LeastTurnsGoalSearch(Map m, int city, int goal, int startStamina,
+                          int stamina, Landmarks landmarks,
+                          struct costedMove *predecessor)
+{
+    assert(LandmarksIsCurrent(landmarks, m));
+    struct goal g = {goal, landmarks};
+    search(m, &city, 1, startStamina, stamina, predecessor, &g);
+}
+
+/**
+ * Runs the search from all of the cities at once over the map's
+ * length-sorted roads
+ */
+void LeastTurnsMultiSearch(Map m, int cities[], int numCities, int stamina,
+                           struct costedMove *predecessor)
+{
+    search(m, cities, numCities, stamina, stamina, predecessor, NULL);
+}
+
+/**
+ * Runs the reference search from all of the cities at once
+ */
+void LeastTurnsReferenceMultiSearch(Map m, int cities[], int numCities,
+                                    int stamina,
+                                    struct costedMove *predecessor)
+{
+    referenceSearch(m, cities, numCities, stamina, stamina, predecessor);
+}
+
+/**
+ * Starts a search over the map's length-sorted roads which has processed
+ * no cities yet
+ */
+PartialSearch LeastTurnsStartSearch(Map m, int city, int startStamina,
+                                    int stamina,
+                                    struct costedMove *predecessor)
+{
+    PartialSearch s = malloc(sizeof(struct partialSearch));
+    if (s == NULL)
+    {
+        printNullError();
+    }
+    s->m = m;
+    s->stamina = stamina;
+    s->predecessor = predecessor;
+    s->q = startSearch(m, &city, 1, startStamina, predecessor);
+    return s;
+}
+
+/**
+ * Processes up to `maxCities` more cities from the search's queue
+ */
+bool LeastTurnsContinueSearch(PartialSearch s, long maxCities)
+{
+    assert(maxCities > 0);
+    return ltpGetMoves(s->q, s->predecessor, s->stamina, s->m, NULL,
+                       maxCities);
+}
+
+/**
+ * Frees the queue and the search
+ */
+void LeastTurnsFreeSearch(PartialSearch s)
+{
+    QueueFree(s->q);
+    free(s);
+}
+
+/**
+ * Initialises every city's label and runs the search from the given cities
+ */
+static void search(Map m, int cities[], int numCities, int startStamina,
+                   int stamina, struct costedMove *predecessor,
+                   struct goal *goal)
+{
+    Queue q = startSearch(m, cities, numCities, startStamina, predecessor);
+    ltpGetMoves(q, predecessor, stamina, m, goal, LONG_MAX);
+    QueueFree(q);
+}
+
+/**
+ * Initialises every city's label and returns a queue holding the given
+ * cities in the order they are given
+ */
+static Queue startSearch(Map m, int cities[], int numCities,
+                         int startStamina, struct costedMove *predecessor)
+{
+    //initialises the predecessor array to have the maximum number of turns 
+    //and maximum total stamina cost
+    for (int i = 0; i < MapNumCities(m); i++)
+    {
+        predecessor[i] = (struct costedMove){(struct move){-1, 0}, 0, INT_MAX};
+    }
+
+    Queue q = QueueNew();
+
+    //initialises the first predecessors with basic data
+    for (int i = 0; i < numCities; i++)
+    {
+        predecessor[cities[i]] = (struct costedMove){(struct move){-1, 0},
+                                                     startStamina, 0};
+        QueueEnqueue(q, cities[i]);
+    }
+    return q;
+}
+
+/**
+ * The following code was adapted from the comp2521 2024T3 Graph Traversal 
+ * slides.
+ * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+ * This gets the moves for LeastTurnsSearch until the queue that holds all the 
+ * cities that still needs to be accounted for is empty, or `maxCities`
+ * cities have been taken from it. Returns true if the queue is empty.
+ */
+static bool ltpGetMoves(Queue q, struct costedMove *predecessor, int stamina,
+                        Map m, struct goal *goal, long maxCities)
+{
+    for (long n = 0; n < maxCities && !QueueIsEmpty(q); n++)
+    {
+        int curr = QueueDequeue(q);
+        // the goal's label may have improved since the city was queued
+        if (cannotReachGoal(goal, predecessor, curr, stamina))
+        {
+            continue;
+        }
+
+        // the map keeps every city's roads in ascending order by length, so
+        // they are decoded one at a time until one is too long
+        struct roadIterator it;
+        MapIterateRoads(m, curr, &it);
+        struct road road;
+        bool more = true;
+        while (more && MapNextRoad(&it, &road))
+        {
+            more = tryRoad(road, q, curr, predecessor, stamina, goal);
+        }
+    }
+    return QueueIsEmpty(q);
+}
+
+/**
+ * Takes the road from the current city if it leads to a better path, or
+ * rests first if the agent cannot afford it. Returns false if the road is
+ * longer than the maximum stamina; the roads are sorted, so none of the
+ * rest can be taken either.
+ */
+static bool tryRoad(struct road road, Queue q, int currentCity,
+                    struct costedMove *predecessor, int stamina,
+                    struct goal *goal)
+{
+    // a road longer than the maximum stamina can never be taken, and
+    // resting for it would never end
+    if (road.length > stamina)
+    {
+        return false;
+    }
+
+    //if including this move in the path currently will result in an
+    //additional move to replenish stamina, then don't update
+    if (predecessor[currentCity].remainingStamina - road.length < 0)
+    {
+        // replenish to max stamina
+        predecessor[currentCity].remainingStamina = stamina;
+        QueueEnqueue(q, currentCity);
+        predecessor[currentCity].numMovesTaken++;
+    } else if (pathNeedsUpdating(road, currentCity, predecessor))
+    {
+        //sets the predecessor of the city that the road leads to. This will
+        //contain the remaining and overall stamina which takes the city's
+        //stamina cost into account
+        predecessor[road.to] = (struct costedMove)
+            {(struct move){currentCity, road.length},
+              predecessor[currentCity].remainingStamina - road.length,
+              predecessor[currentCity].numMovesTaken + 1};
+        if (!cannotReachGoal(goal, predecessor, road.to, stamina))
+        {
+            QueueEnqueue(q, road.to);
+        }
+    }
+    return true;
+}
+
+/**
+ * checks if the current road is leading to a city that has not been explored or
+ * if it's the thief's location, checks if taken this road would lead to a path
+ * with less turns than the current. If it takes the same number of turns, check
+ * if it takes less stamina and returns true if it does.
+ */
+static bool pathNeedsUpdating(struct road road, int currentCity,
+                              struct costedMove *predecessor)
+{
+    bool needsUpdating = true;
+
+    //checks if this road leads to a path with less turns used
+    if (predecessor[currentCity].numMovesTaken + 1 <
+        predecessor[road.to].numMovesTaken)
+    {
+        needsUpdating = true;
+    }
+    else if (predecessor[currentCity].numMovesTaken + 1 ==
+                predecessor[road.to].numMovesTaken)
+    {
+        //checks if this road leads to a path which leaves the agent with the
+        //most stamina
+        if (predecessor[currentCity].remainingStamina - road.length
+            > predecessor[road.to].remainingStamina)
+        {
+            needsUpdating = true;
+        }
+        else
+        {
+            needsUpdating = false;
+        }
+    }
+    else
+    {
+        needsUpdating = false;
+    }
+
+    return needsUpdating;
+}
+
+/**
+ * Returns true if the goal search has already found a path to the goal
+ * with fewer turns than any path through the city's current label could
+ * take. Always false when there is no goal.
+ */
+static bool cannotReachGoal(struct goal *goal, struct costedMove *predecessor,
+                            int city, int stamina)
+{
+    if (goal == NULL || predecessor[goal->city].numMovesTaken == INT_MAX)
+    {
+        return false;
+    }
+    return predecessor[city].numMovesTaken +
+               minTurnsToGoal(goal, city, predecessor[city].remainingStamina,
+                              stamina) >
+           predecessor[goal->city].numMovesTaken;
+}
+
+/**
+ * Returns a lower bound on the number of turns from the city to the goal.
+ * A path of length D takes at least D / stamina moves, since no road is
+ * longer than the stamina, and at least (D - remainingStamina) / stamina
+ * rests to pay for it.
+ */
+static long minTurnsToGoal(struct goal *goal, int city, int remainingStamina,
+                           int stamina)
+{
+    if (city == goal->city)
+    {
+        return 0;
+    }
+    long distance = LandmarksLowerBound(goal->landmarks, city, goal->city);
+    if (distance == -1)
+    {
+        return INT_MAX;
+    }
+
+    long moves = (distance + stamina - 1) / stamina;
+    long rests = 0;
+    if (distance > remainingStamina)
+    {
+        rests = (distance - remainingStamina + stamina - 1) / stamina;
+    }
+    return (moves > 1 ? moves : 1) + rests;
+}
+
+/**
+ * Initialises every city's label and runs the reference search from the
+ * given cities
+ */
+static void referenceSearch(Map m, int cities[], int numCities,
+                            int startStamina, int stamina,
+                            struct costedMove *predecessor)
+{
+    //initialises the predecessor array to have the maximum number of turns 
+    //and maximum total stamina cost
+    for (int i = 0; i < MapNumCities(m); i++)
+    {
+        predecessor[i] = (struct costedMove){(struct move){-1, 0}, 0, INT_MAX};
+    }
+
+    Queue q = QueueNew();
+
+    //initialises the first predecessors with basic data
+    for (int i = 0; i < numCities; i++)
+    {
+        predecessor[cities[i]] = (struct costedMove){(struct move){-1, 0},
+                                                     startStamina, 0};
+        QueueEnqueue(q, cities[i]);
+    }
+
+    referenceGetMoves(q, predecessor, stamina, m);
+
+    QueueFree(q);
+}
+
+/**
+ * The following code was adapted from the comp2521 2024T3 Graph Traversal 
+ * slides.
+ * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+ * This gets the moves for referenceSearch until the queue that holds all the 
+ * cities that still needs to be accounted for is empty
+ */
+static void referenceGetMoves(Queue q, struct costedMove *predecessor,
+                              int stamina, Map m)
+{
+    while (!QueueIsEmpty(q))
+    {
+        int curr = QueueDequeue(q);
+
+        struct road *roads = createRoads(m);
+
+        // Get all roads to adjacent cities
+        int numRoads = MapGetRoadsFrom(m, curr, roads);
+        // sorts the roads in ascending order by the length.
+        qsort(roads, numRoads, sizeof(struct road), compare);
+
+        referenceFillQueue(roads, numRoads, q, curr, predecessor, stamina);
+
+        free(roads);
+    }
+}
+
+/**
+ * Comparison function used by qsort that sorts the two roads given as the
+ * parameters by ascending order.
+ */
+static int compare(const void *a, const void *b)
+{
+    struct road *x = (struct road *)a;
+    struct road *y = (struct road *)b;
+    return x->length - y->length;
+}
+
+/**
+ * The following code was adapted from the comp2521 2024T3 Graph Traversal 
+ * slides.
+ * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/Week5Mon-graph-traversal.pdf
+ * Enqueues all the non-visited cities that is adjacent to the current city into
+ * the queue.
+ */
+static void referenceFillQueue(struct road *roads, int roadSize, Queue q,
+                               int currentCity,
+                               struct costedMove *predecessor, int stamina)
+{
+    for (int i = 0; i < roadSize; i++)
+    {
+        //if including this move in the path currently will result in an
+        //additional move to replenish stamina, then don't update
+        if (predecessor[currentCity].remainingStamina - roads[i].length 
+            < 0)
+        {
+            // replenish to max stamina
+            predecessor[currentCity].remainingStamina = stamina;
+            QueueEnqueue(q, currentCity);
+            predecessor[currentCity].numMovesTaken++;
+        } else if (referencePathNeedsUpdating(roads, currentCity, predecessor,
+                                              i))
+        {
+            //sets the predecessor of the city that the road leads to. This will
+            //contain the remaining and overall stamina which takes the city's
+            //stamina cost into account
+            predecessor[roads[i].to] = (struct costedMove)
+                {(struct move){currentCity, roads[i].length},
+                  predecessor[currentCity].remainingStamina - roads[i].length,
+                  predecessor[currentCity].numMovesTaken + 1};
+            QueueEnqueue(q, roads[i].to);
+        }
+    }
+}
+
+/**
+ * checks if the current road is leading to a city that has not been explored or
+ * if it's the thief's location, checks if taken this road would lead to a path
+ * with less turns than the current. If it takes the same number of turns, check
+ * if it takes less stamina and returns true if it does.
+ */
+static bool referencePathNeedsUpdating(struct road *roads, int currentCity,
+                                       struct costedMove *predecessor,
+                                       int index)
+{
+    bool needsUpdating = true;
+
+    //checks if this road leads to a path with less turns used
+    if (predecessor[currentCity].numMovesTaken + 1 <
+        predecessor[roads[index].to].numMovesTaken)
+    {
+        needsUpdating = true;
+    }
+    else if (predecessor[currentCity].numMovesTaken + 1 ==
+                predecessor[roads[index].to].numMovesTaken)
+    {
+        //checks if this road leads to a path which leaves the agent with the
+        //most stamina
+        if (predecessor[currentCity].remainingStamina - roads[index].length
+            > predecessor[roads[index].to].remainingStamina)
+        {
+            needsUpdating = true;
+        }
+        else
+        {
+            needsUpdating = false;
+        }
+    }
+    else
+    {
+        needsUpdating = false;
+    }
+
+    return needsUpdating;
+}
+
+/**
+ * Marks every city unlabelled apart from the starting city, which makes up
+ * the first frontier. Stores the number of roads from unlabelled cities in
+ * `*unlabelledRoads` and returns the number of roads from the frontier.
+ */
+static long startParallelSearch(struct parallelSearch *s, int city,
+                               int startStamina, long *unlabelledRoads)
+{
+    *unlabelledRoads = 0;
+    for (int i = 0; i < MapNumCities(s->m); i++)
+    {
+        s->predecessor[i] = (struct costedMove){(struct move){-1, 0}, 0,
+                                                INT_MAX};
+        atomic_init(&s->best[i], 0);
+        s->frontierStamina[i] = -1;
+        s->mustRest[i] = false;
+        *unlabelledRoads += MapNumRoadsFrom(s->m, i);
+    }
+
+    s->predecessor[city] = (struct costedMove){(struct move){-1, 0},
+                                               startStamina, 0};
+    s->frontierStamina[city] = startStamina;
+    s->mustRest[city] = needsRest(s->m, city, startStamina, s->stamina);
+    s->frontier[0] = city;
+    s->frontierSize = 1;
+    s->turns = 0;
+    *unlabelledRoads -= MapNumRoadsFrom(s->m, city);
+    return MapNumRoadsFrom(s->m, city);
+}
+
+/**
+ * Runs the task over the elements 0 to `size` - 1 of whatever it goes
+ * through, split into ranges on the pool's threads, or in one go on the
+ * calling thread if there is no pool or too few to be worth splitting
+ */
+static void runTasks(struct parallelSearch *s, PoolTask task, int size)
+{
+    int numTasks = s->pool == NULL ? 1
+                                   : PoolNumThreads(s->pool) * TASKS_PER_THREAD;
+    if (numTasks > size / MIN_CITIES_PER_TASK)
+    {
+        numTasks = size / MIN_CITIES_PER_TASK;
+    }
+    if (numTasks <= 1)
+    {
+        struct searchTask all = {s, 0, size};
+        task(&all);
+        return;
+    }
+
+    struct searchTask *tasks = malloc(numTasks * sizeof(struct searchTask));
+    if (tasks == NULL)
+    {
+        printNullError();
+    }
+    for (int i = 0; i < numTasks; i++)
+    {
+        tasks[i] = (struct searchTask){s, (long)size * i / numTasks,
+                                       (long)size * (i + 1) / numTasks};
+        PoolSubmit(s->pool, task, &tasks[i]);
+    }
+    PoolWait(s->pool);
+    free(tasks);
+}
+
+/**
+ * Offers every unlabelled city one road from the task's frontier cities the
+ * stamina it would be left with. A city which has rested only needs to try
+ * the roads it could not afford before resting.
+ */
+static void searchTopDown(void *arg)
+{
+    struct searchTask *task = arg;
+    struct parallelSearch *s = task->s;
+    struct reachedBuffer buffer = {.numCities = 0};
+
+    for (int i = task->first; i < task->last; i++)
+    {
+        int from = s->frontier[i];
+        int setOut = s->frontierStamina[from];
+        int arrival = s->predecessor[from].remainingStamina;
+        int minLength = setOut > arrival ? arrival + 1 : 0;
+
+        struct roadIterator it;
+        MapIterateRoads(s->m, from, &it);
+        struct road road;
+        while (MapNextRoad(&it, &road) && road.length <= setOut)
+        {
+            if (road.length >= minLength &&
+                s->predecessor[road.to].numMovesTaken == INT_MAX)
+            {
+                offerLabel(s, road.to, labelKey(setOut - road.length, from),
+                           &buffer);
+            }
+        }
+    }
+    flushReached(s, &buffer);
+}
+
+/**
+ * Labels every unlabelled city in the task's range that has a road from a
+ * frontier city it can afford, with the best of them
+ */
+static void searchBottomUp(void *arg)
+{
+    struct searchTask *task = arg;
+    struct parallelSearch *s = task->s;
+    struct reachedBuffer buffer = {.numCities = 0};
+
+    for (int city = task->first; city < task->last; city++)
+    {
+        if (s->predecessor[city].numMovesTaken != INT_MAX)
+        {
+            continue;
+        }
+
+        uint64_t best = 0;
+        struct roadIterator it;
+        MapIterateRoads(s->m, city, &it);
+        struct road road;
+        while (MapNextRoad(&it, &road) && road.length <= s->stamina)
+        {
+            int setOut = s->frontierStamina[road.to];
+            if (setOut >= road.length)
+            {
+                uint64_t key = labelKey(setOut - road.length, road.to);
+                best = key > best ? key : best;
+            }
+        }
+
+        // no other task looks at this city, so no atomic maximum is needed
+        if (best != 0)
+        {
+            atomic_store_explicit(&s->best[city], best, memory_order_relaxed);
+            addReached(s, city, &buffer);
+        }
+    }
+    flushReached(s, &buffer);
+}
+
+/**
+ * Raises the city's best label to the given key if it is better, and
+ * records the city as reached if this is the first label it was offered
+ */
+static void offerLabel(struct parallelSearch *s, int city, uint64_t key,
+                       struct reachedBuffer *buffer)
+{
+    uint64_t old = atomic_load_explicit(&s->best[city], memory_order_relaxed);
+    while (key > old)
+    {
+        if (atomic_compare_exchange_weak_explicit(&s->best[city], &old, key,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        {
+            if (old == 0)
+            {
+                addReached(s, city, buffer);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * Adds the city to the task's buffer of reached cities, adding the buffer
+ * to the shared list first if it is full
+ */
+static void addReached(struct parallelSearch *s, int city,
+                       struct reachedBuffer *buffer)
+{
+    if (buffer->numCities == REACHED_BUFFER_SIZE)
+    {
+        flushReached(s, buffer);
+    }
+    buffer->cities[buffer->numCities++] = city;
+}
+
+/**
+ * Adds the task's buffer of reached cities to the shared list and empties it
+ */
+static void flushReached(struct parallelSearch *s,
+                         struct reachedBuffer *buffer)
+{
+    int start = atomic_fetch_add_explicit(&s->numReached, buffer->numCities,
+                                          memory_order_relaxed);
+    memcpy(&s->reached[start], buffer->cities,
+           buffer->numCities * sizeof(int));
+    buffer->numCities = 0;
+}
+
+/**
+ * Turns the best label offered to each of the task's reached cities into
+ * its least turns label
+ */
+static void labelReached(void *arg)
+{
+    struct searchTask *task = arg;
+    struct parallelSearch *s = task->s;
+
+    for (int i = task->first; i < task->last; i++)
+    {
+        int city = s->reached[i];
+        uint64_t key = atomic_load_explicit(&s->best[city],
+                                            memory_order_relaxed);
+        int remainingStamina = (int)(key >> 32) - 1;
+        int from = (int)~(uint32_t)key;
+        s->predecessor[city] = (struct costedMove)
+            {(struct move){from, s->frontierStamina[from] - remainingStamina},
+             remainingStamina, s->turns + 1};
+        s->mustRest[city] = needsRest(s->m, city, remainingStamina,
+                                      s->stamina);
+    }
+}
+
+/**
+ * Makes the next frontier out of the cities just reached and the frontier
+ * cities which have to rest before going on, takes the cities just reached
+ * off `*unlabelledRoads` and returns the number of roads from the frontier
+ */
+static long nextLevel(struct parallelSearch *s, long *unlabelledRoads)
+{
+    for (int i = 0; i < s->frontierSize; i++)
+    {
+        s->frontierStamina[s->frontier[i]] = -1;
+    }
+
+    long frontierRoads = 0;
+    int size = 0;
+    for (int i = 0; i < s->frontierSize; i++)
+    {
+        int city = s->frontier[i];
+        // cities which have already rested were reached a level earlier
+        if (s->mustRest[city] &&
+            s->predecessor[city].numMovesTaken == s->turns)
+        {
+            s->nextFrontier[size++] = city;
+            s->frontierStamina[city] = s->stamina;
+            frontierRoads += MapNumRoadsFrom(s->m, city);
+        }
+    }
+
+    int numReached = atomic_load_explicit(&s->numReached,
+                                          memory_order_relaxed);
+    for (int i = 0; i < numReached; i++)
+    {
+        int city = s->reached[i];
+        s->nextFrontier[size++] = city;
+        s->frontierStamina[city] = s->predecessor[city].remainingStamina;
+        frontierRoads += MapNumRoadsFrom(s->m, city);
+        *unlabelledRoads -= MapNumRoadsFrom(s->m, city);
+    }
+
+    int *old = s->frontier;
+    s->frontier = s->nextFrontier;
+    s->nextFrontier = old;
+    s->frontierSize = size;
+    return frontierRoads;
+}
+
+/**
+ * Returns true if an agent with the given stamina left in the city would
+ * have to rest before taking one of its roads
+ */
+static bool needsRest(Map m, int city, int remainingStamina, int stamina)
+{
+    struct roadIterator it;
+    MapIterateRoads(m, city, &it);
+    struct road road;
+    while (MapNextRoad(&it, &road))
+    {
+        if (road.length > remainingStamina)
+        {
+            return road.length <= stamina;
+        }
+    }
+    return false;
+}
+
+/**
+ * Packs a label so that a larger key leaves more stamina, or the same
+ * stamina from a lower-numbered city
+ */
+static uint64_t labelKey(int remainingStamina, int from)
+{
+    return (uint64_t)(remainingStamina + 1) << 32 | (uint32_t)~from;
+}
+
+/**
+ * Allocates memory for a roads array.
+ */
+static struct road *createRoads(Map m)
+{
+    struct road *roads = malloc(MapNumCities(m) * sizeof(struct road));
+    if (roads == NULL)
+    {
+        printNullError();
+    }
+    return roads;
+}
+
+/**
+ * Prints an error message when the program attempted to allocate memory but
+ * did not succeed. Then exits the program.
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
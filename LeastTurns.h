@@ -0,0 +1,126 @@
+// Interface to the least turns search
+// Finds, for every city, the path from a starting city that takes the least
+// number of turns, where an agent that cannot afford a road must spend a turn
+// resting to recover its stamina. If several paths take the least number of
+// turns, the one leaving the agent with the most stamina is preferred.
+
+#ifndef LEAST_TURNS_H
+#define LEAST_TURNS_H
+
+#include <stdbool.h>
+
+#include "Agent.h"
+#include "Landmarks.h"
+#include "Map.h"
+#include "Pool.h"
+
+// This struct is used for simulating the path that the agent takes with the
+// expected remaining stamina when the agent is in the city of an informant.
+// `m.to` is the city before this one on the path (or -1 for the starting
+// city and unreachable cities) and `m.staminaCost` is the length of the road
+// between them.
+struct costedMove {
+    struct move m;
+    int remainingStamina;
+    int numMovesTaken; // INT_MAX for cities that cannot be reached
+};
+
+// A least turns search which can be carried out a few cities at a time
+typedef struct partialSearch *PartialSearch;
+
+/**
+ * Fills `predecessor` (which must have room for every city) with the least
+ * turns path from the given city to every other city, for an agent that
+ * starts with `startStamina` and rests back up to `stamina`.
+ * Since roads are bidirectional, a search from the thief's location can also
+ * be followed backwards from any city to reach the thief.
+ */
+void LeastTurnsSearch(Map m, int city, int startStamina, int stamina,
+                      struct costedMove *predecessor);
+
+/**
+ * Does the same search as LeastTurnsSearch on the given pool's threads, one
+ * number of turns at a time. Every city gets the same `numMovesTaken` and
+ * `remainingStamina` as from LeastTurnsSearch, but where several paths do
+ * that it may be a different one of them. Its choice does not depend on the
+ * number of threads or how they are scheduled. With a NULL pool the search
+ * runs on the calling thread.
+ * NOTE: The search waits for the pool to be idle, so the pool must not be
+ *       shared with other work, including the task that calls the search
+ */
+void LeastTurnsParallelSearch(Map m, int city, int startStamina, int stamina,
+                              struct costedMove *predecessor, Pool pool);
+
+/**
+ * The reference engine's version of LeastTurnsSearch: a copy of the search
+ * as it was first written, which sorts each city's roads by length as it
+ * processes the city instead of using the map's length-sorted roads. Fills
+ * `predecessor` with the same paths.
+ * NOTE: Like the original, it never ends if a road is longer than `stamina`
+ */
+void LeastTurnsReferenceSearch(Map m, int city, int startStamina, int stamina,
+                               struct costedMove *predecessor);
+
+/**
+ * Fills `predecessor` with the least turns path to every city from whichever
+ * of the given cities it can be reached from in the fewest turns, for an
+ * agent that starts with full stamina in any of them. Following a city's
+ * path backwards leads to the nearest of the given cities, and its
+ * `numMovesTaken` is the number of turns it takes to get there.
+ * Does nothing but mark every city unreachable if `numCities` is 0.
+ */
+void LeastTurnsMultiSearch(Map m, int cities[], int numCities, int stamina,
+                           struct costedMove *predecessor);
+
+/**
+ * The reference engine's version of LeastTurnsMultiSearch, which runs the
+ * reference search from all of the cities at once. Fills `predecessor` with
+ * the same paths.
+ * NOTE: Like the original, it never ends if a road is longer than `stamina`
+ */
+void LeastTurnsReferenceMultiSearch(Map m, int cities[], int numCities,
+                                    int stamina,
+                                    struct costedMove *predecessor);
+
+/**
+ * Starts a search like LeastTurnsSearch, but labels only the given city.
+ * Call LeastTurnsContinueSearch to carry it on. Until it is finished, every
+ * city in `predecessor` with a path (numMovesTaken below INT_MAX) can be
+ * followed back to the starting city, but the path may take more turns
+ * than the least.
+ * NOTE: `predecessor` belongs to the caller and must outlive the search
+ */
+PartialSearch LeastTurnsStartSearch(Map m, int city, int startStamina,
+                                    int stamina,
+                                    struct costedMove *predecessor);
+
+/**
+ * Carries on the search by taking at most `maxCities` cities from its queue
+ * (a city may be taken more than once). Returns true if the search has
+ * finished, in which case `predecessor` holds the same paths as
+ * LeastTurnsSearch would have given.
+ * Assumes that `maxCities` is positive and the roads have not changed since
+ * the search started
+ */
+bool LeastTurnsContinueSearch(PartialSearch s, long maxCities);
+
+/**
+ * Frees all memory allocated to the search, finished or not
+ */
+void LeastTurnsFreeSearch(PartialSearch s);
+
+/**
+ * Fills in the least turns path from the given city to the goal city only.
+ * The landmarks give a lower bound on the number of turns from every city
+ * to the goal, and cities which cannot be on a path with fewer turns than
+ * the best path found so far are not explored. The goal gets the same path
+ * as it would from LeastTurnsSearch; the labels of other cities may be left
+ * unfinished.
+ * Assumes that the landmarks are current for the map
+ */
+void LeastTurnsGoalSearch(Map m, int city, int goal, int startStamina,
+                          int stamina, Landmarks landmarks,
+                          struct costedMove *predecessor);
+
+#endif
+
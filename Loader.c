@@ -0,0 +1,661 @@
+// Implementation of the data file loader
+// Each line of the city data file is read whole and then split into the
+// city's roads, its informant flag and its name, which are collected in a
+// chunk of parsed lines. Once every line has been parsed the map is built
+// from the chunks in one go, with all the roads inserted at once. The agent
+// data file is read with fscanf, a line per agent, until the end of the
+// file.
+//
+// A parallel read maps the city data file into memory and splits it into
+// chunks that end at the end of a line, so each chunk can be parsed on its
+// own thread into its own buffers. The chunks are built into the map in
+// the order they appear in the file, so the map is the same as from a read
+// on one thread.
+
+#define _POSIX_C_SOURCE 200809L // for getline
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Agent.h"
+#include "Loader.h"
+#include "Map.h"
+#include "Pool.h"
+
+#define MIN_CHUNK_BYTES (1 << 20) // smaller parts are not worth a thread
+#define CHUNKS_PER_THREAD 4
+
+// Where the name on a city line went in its chunk
+struct cityLine
+{
+    int city;
+    bool hasInformant;
+    size_t name; // offset into the chunk's names
+};
+
+// The lines parsed from one part of the city data file, in the order they
+// appear in it
+struct cityChunk
+{
+    const char *start; // the part of a mapped file, for a parallel read
+    const char *end;
+    int numCities; // on the map, to check the roads against
+    bool ok;
+
+    struct road *roads;
+    long numRoads;
+    long roadsSize;
+    struct cityLine *lines;
+    int numLines;
+    int linesSize;
+    char *names;
+    size_t namesLength;
+    size_t namesSize;
+
+    char *line; // a copy of the line being parsed from a mapped file
+    size_t lineSize;
+};
+
+static void printNullError(void);
+
+static void startChunk(struct cityChunk *chunk, int numCities);
+static void freeChunk(struct cityChunk *chunk);
+static bool readNumCities(const char *text, size_t size, int *numCities,
+                          size_t *bodyStart);
+static void splitChunks(struct cityChunk chunks[], int numChunks,
+                        const char *body, const char *end);
+static void readChunk(void *arg);
+static void copyLine(struct cityChunk *chunk, const char *start,
+                     const char *end);
+static bool readCity(struct cityChunk *chunk, char *line);
+static void addRoad(struct cityChunk *chunk, int city, int to, int length);
+static void addLine(struct cityChunk *chunk, int city, bool hasInformant,
+                    char *name);
+static Map buildMap(struct cityChunk chunks[], int numChunks, int numCities);
+static bool readAgent(FILE *fp, struct agentData *agent, int *third);
+static bool validStrategy(int strategy);
+static bool atEndOfFile(FILE *fp);
+static char *skipSpaces(char *s);
+static void trimName(char *name);
+
+/**
+ * Reads the number of cities and then one line per city
+ */
+Map LoaderReadCities(char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+
+    int numCities;
+    if (fscanf(fp, "%d", &numCities) != 1 || numCities <= 0)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    struct cityChunk chunk;
+    startChunk(&chunk, numCities);
+    char *line = NULL;
+    size_t lineSize = 0;
+    while (chunk.ok && getline(&line, &lineSize, fp) != -1)
+    {
+        if (*skipSpaces(line) != '\0')
+        {
+            chunk.ok = readCity(&chunk, line);
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    Map m = buildMap(&chunk, 1, numCities);
+    freeChunk(&chunk);
+    return m;
+}
+
+/**
+ * Maps the file into memory, parses its chunks on the pool and builds the
+ * map from them
+ */
+Map LoaderReadCitiesParallel(char *filename, Pool pool)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && !S_ISREG(st.st_mode))
+    {
+        // pipes and the like cannot be mapped
+        close(fd);
+        return LoaderReadCities(filename);
+    }
+    if (fstat(fd, &st) == -1 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    size_t size = st.st_size;
+    const char *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    int numCities;
+    size_t bodyStart;
+    if (!readNumCities(text, size, &numCities, &bodyStart))
+    {
+        munmap((void *)text, size);
+        return NULL;
+    }
+
+    int numChunks = pool == NULL ? 1 : PoolNumThreads(pool) * CHUNKS_PER_THREAD;
+    if ((size_t)numChunks > (size - bodyStart) / MIN_CHUNK_BYTES)
+    {
+        numChunks = (size - bodyStart) / MIN_CHUNK_BYTES;
+    }
+    numChunks = numChunks > 1 ? numChunks : 1;
+
+    struct cityChunk *chunks = malloc(numChunks * sizeof(struct cityChunk));
+    if (chunks == NULL)
+    {
+        printNullError();
+    }
+    for (int i = 0; i < numChunks; i++)
+    {
+        startChunk(&chunks[i], numCities);
+    }
+    splitChunks(chunks, numChunks, text + bodyStart, text + size);
+    if (numChunks == 1)
+    {
+        readChunk(&chunks[0]);
+    }
+    else
+    {
+        for (int i = 0; i < numChunks; i++)
+        {
+            PoolSubmit(pool, readChunk, &chunks[i]);
+        }
+        PoolWait(pool);
+    }
+
+    Map m = buildMap(chunks, numChunks, numCities);
+    for (int i = 0; i < numChunks; i++)
+    {
+        freeChunk(&chunks[i]);
+    }
+    free(chunks);
+    munmap((void *)text, size);
+    return m;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Starts an empty chunk for a map with the given number of cities
+ */
+static void startChunk(struct cityChunk *chunk, int numCities)
+{
+    *chunk = (struct cityChunk){.numCities = numCities, .ok = true};
+}
+
+/**
+ * Frees the chunk's buffers
+ */
+static void freeChunk(struct cityChunk *chunk)
+{
+    free(chunk->roads);
+    free(chunk->lines);
+    free(chunk->names);
+    free(chunk->line);
+}
+
+/**
+ * Reads the number of cities at the start of the mapped file as fscanf's
+ * "%d" would, and stores where the rest of the file starts. Returns false
+ * if there is no positive number.
+ */
+static bool readNumCities(const char *text, size_t size, int *numCities,
+                          size_t *bodyStart)
+{
+    size_t i = 0;
+    while (i < size && strchr(" \t\n\v\f\r", text[i]) != NULL &&
+           text[i] != '\0')
+    {
+        i++;
+    }
+
+    char number[32];
+    size_t length = size - i < sizeof(number) - 1 ? size - i
+                                                  : sizeof(number) - 1;
+    memcpy(number, text + i, length);
+    number[length] = '\0';
+
+    int used;
+    if (sscanf(number, "%d%n", numCities, &used) != 1 || *numCities <= 0)
+    {
+        return false;
+    }
+    *bodyStart = i + used;
+    return true;
+}
+
+/**
+ * Splits the text into roughly equal chunks, moving the end of each chunk
+ * on to the end of a line
+ */
+static void splitChunks(struct cityChunk chunks[], int numChunks,
+                        const char *body, const char *end)
+{
+    const char *start = body;
+    for (int i = 0; i < numChunks; i++)
+    {
+        const char *split = end;
+        if (i < numChunks - 1)
+        {
+            split = body + (end - body) * (i + 1) / numChunks;
+            split = split > start ? split : start;
+            const char *newline = memchr(split, '\n', end - split);
+            split = newline == NULL ? end : newline + 1;
+        }
+        chunks[i].start = start;
+        chunks[i].end = split;
+        start = split;
+    }
+}
+
+/**
+ * Parses every line in the chunk's part of the file, stopping at the first
+ * malformed line
+ */
+static void readChunk(void *arg)
+{
+    struct cityChunk *chunk = arg;
+    const char *p = chunk->start;
+    while (chunk->ok && p < chunk->end)
+    {
+        const char *newline = memchr(p, '\n', chunk->end - p);
+        const char *lineEnd = newline == NULL ? chunk->end : newline + 1;
+        copyLine(chunk, p, lineEnd);
+        p = lineEnd;
+        if (*skipSpaces(chunk->line) != '\0')
+        {
+            chunk->ok = readCity(chunk, chunk->line);
+        }
+    }
+}
+
+/**
+ * Copies a line of the mapped file into the chunk's line buffer with a
+ * terminating null character, as getline would read it
+ */
+static void copyLine(struct cityChunk *chunk, const char *start,
+                     const char *end)
+{
+    size_t length = end - start;
+    if (length + 1 > chunk->lineSize)
+    {
+        chunk->lineSize = 2 * (length + 1);
+        chunk->line = realloc(chunk->line, chunk->lineSize);
+        if (chunk->line == NULL)
+        {
+            printNullError();
+        }
+    }
+    memcpy(chunk->line, start, length);
+    chunk->line[length] = '\0';
+}
+
+/**
+ * Reads one line of city data into the chunk: the city's ID, pairs of
+ * (city, length) for its roads, 'i' or 'n' and then the name of the city,
+ * which may be at most MAX_NAME_LENGTH characters long
+ */
+static bool readCity(struct cityChunk *chunk, char *line)
+{
+    char *end;
+    int city = strtol(line, &end, 10);
+    if (end == line || city < 0 || city >= chunk->numCities)
+    {
+        return false;
+    }
+
+    char *s = skipSpaces(end);
+    while (*s != 'i' && *s != 'n')
+    {
+        int to = strtol(s, &end, 10);
+        if (end == s)
+        {
+            return false;
+        }
+        int length = strtol(end, &s, 10);
+        if (s == end || to < 0 || to >= chunk->numCities || to == city ||
+            length <= 0)
+        {
+            return false;
+        }
+        addRoad(chunk, city, to, length);
+        s = skipSpaces(s);
+    }
+
+    char *name = skipSpaces(s + 1);
+    trimName(name);
+    if (strlen(name) > MAX_NAME_LENGTH)
+    {
+        return false;
+    }
+    addLine(chunk, city, *s == 'i', name);
+    return true;
+}
+
+/**
+ * Adds a road to the chunk
+ */
+static void addRoad(struct cityChunk *chunk, int city, int to, int length)
+{
+    if (chunk->numRoads == chunk->roadsSize)
+    {
+        chunk->roadsSize = chunk->roadsSize == 0 ? 64 : 2 * chunk->roadsSize;
+        chunk->roads = realloc(chunk->roads,
+                               chunk->roadsSize * sizeof(struct road));
+        if (chunk->roads == NULL)
+        {
+            printNullError();
+        }
+    }
+    chunk->roads[chunk->numRoads++] = (struct road){city, to, length};
+}
+
+/**
+ * Adds a city's informant flag and a copy of its name to the chunk
+ */
+static void addLine(struct cityChunk *chunk, int city, bool hasInformant,
+                    char *name)
+{
+    if (chunk->numLines == chunk->linesSize)
+    {
+        chunk->linesSize = chunk->linesSize == 0 ? 64 : 2 * chunk->linesSize;
+        chunk->lines = realloc(chunk->lines,
+                               chunk->linesSize * sizeof(struct cityLine));
+        if (chunk->lines == NULL)
+        {
+            printNullError();
+        }
+    }
+    size_t length = strlen(name) + 1;
+    while (chunk->namesLength + length > chunk->namesSize)
+    {
+        chunk->namesSize = chunk->namesSize == 0 ? 1024
+                                                 : 2 * chunk->namesSize;
+        chunk->names = realloc(chunk->names, chunk->namesSize);
+        if (chunk->names == NULL)
+        {
+            printNullError();
+        }
+    }
+    memcpy(chunk->names + chunk->namesLength, name, length);
+    chunk->lines[chunk->numLines++] =
+        (struct cityLine){city, hasInformant, chunk->namesLength};
+    chunk->namesLength += length;
+}
+
+/**
+ * Builds a map from the chunks, taken in order, or returns NULL if any of
+ * them has a malformed line or there is not exactly one line per city
+ */
+static Map buildMap(struct cityChunk chunks[], int numChunks, int numCities)
+{
+    long numLines = 0;
+    long numRoads = 0;
+    for (int i = 0; i < numChunks; i++)
+    {
+        if (!chunks[i].ok)
+        {
+            return NULL;
+        }
+        numLines += chunks[i].numLines;
+        numRoads += chunks[i].numRoads;
+    }
+    if (numLines != numCities)
+    {
+        return NULL;
+    }
+
+    // with as many lines as cities, no city is repeated only if every city
+    // has its line
+    bool *seen = calloc(numCities, sizeof(bool));
+    if (seen == NULL)
+    {
+        printNullError();
+    }
+    bool repeated = false;
+    for (int i = 0; i < numChunks && !repeated; i++)
+    {
+        for (int j = 0; j < chunks[i].numLines && !repeated; j++)
+        {
+            repeated = seen[chunks[i].lines[j].city];
+            seen[chunks[i].lines[j].city] = true;
+        }
+    }
+    free(seen);
+    if (repeated)
+    {
+        return NULL;
+    }
+
+    Map m = MapNew(numCities);
+    struct road *roads = chunks[0].roads;
+    if (numChunks > 1)
+    {
+        roads = malloc(numRoads * sizeof(struct road));
+        if (roads == NULL && numRoads > 0)
+        {
+            printNullError();
+        }
+        long numCopied = 0;
+        for (int i = 0; i < numChunks; i++)
+        {
+            memcpy(roads + numCopied, chunks[i].roads,
+                   chunks[i].numRoads * sizeof(struct road));
+            numCopied += chunks[i].numRoads;
+        }
+    }
+    MapInsertRoads(m, roads, numRoads);
+    if (numChunks > 1)
+    {
+        free(roads);
+    }
+
+    for (int i = 0; i < numChunks; i++)
+    {
+        for (int j = 0; j < chunks[i].numLines; j++)
+        {
+            struct cityLine *line = &chunks[i].lines[j];
+            MapSetInformant(m, line->city, line->hasInformant);
+            MapSetName(m, line->city, chunks[i].names + line->name);
+        }
+    }
+    return m;
+}
+
+/**
+ * Reads the thief followed by the detectives
+ */
+bool LoaderReadAgents(char *filename, struct gameData *data)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        return false;
+    }
+
+    bool ok = readAgent(fp, &data->thief, &data->getaway);
+    data->thief.strategy = RANDOM;
+
+    int size = NUM_DETECTIVES;
+    data->numDetectives = 0;
+    data->detectives = malloc(size * sizeof(struct agentData));
+    if (data->detectives == NULL)
+    {
+        printNullError();
+    }
+    while (ok && !atEndOfFile(fp))
+    {
+        if (data->numDetectives == size)
+        {
+            size *= 2;
+            data->detectives = realloc(data->detectives,
+                                       size * sizeof(struct agentData));
+            if (data->detectives == NULL)
+            {
+                printNullError();
+            }
+        }
+        struct agentData *detective = &data->detectives[data->numDetectives++];
+        ok = readAgent(fp, detective, &detective->strategy);
+    }
+    fclose(fp);
+
+    if (!ok || data->numDetectives == 0)
+    {
+        LoaderFreeAgents(data);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks the agents' cities, stamina and strategies against the map
+ */
+char *LoaderCheckAgents(Map m, struct gameData *data)
+{
+    int numCities = MapNumCities(m);
+    if (data->getaway < 0 || data->getaway >= numCities)
+    {
+        return "the getaway city is not on the map";
+    }
+    if (data->thief.start < 0 || data->thief.start >= numCities ||
+        data->thief.stamina <= 0)
+    {
+        return "the thief's start city or stamina is invalid";
+    }
+    if (data->thief.strategy != RANDOM &&
+        data->thief.strategy != GETAWAY_SEEKING &&
+        data->thief.strategy != STATIONARY)
+    {
+        return "the thief's strategy is invalid";
+    }
+    for (int d = 0; d < data->numDetectives; d++)
+    {
+        struct agentData *detective = &data->detectives[d];
+        if (detective->start < 0 || detective->start >= numCities ||
+            detective->stamina <= 0 || !validStrategy(detective->strategy))
+        {
+            return "a detective's start city, stamina or strategy is "
+                   "invalid";
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Frees the detectives
+ */
+void LoaderFreeAgents(struct gameData *data)
+{
+    free(data->detectives);
+    data->detectives = NULL;
+    data->numDetectives = 0;
+}
+
+/**
+ * Reads a line of agent data: stamina, starting city, a third number (the
+ * getaway city for the thief and the strategy for a detective) and a name
+ */
+static bool readAgent(FILE *fp, struct agentData *agent, int *third)
+{
+    char format[32];
+    snprintf(format, sizeof(format), "%%d %%d %%d %%%d[^\n]",
+             MAX_NAME_LENGTH);
+    if (fscanf(fp, format, &agent->stamina, &agent->start, third,
+               agent->name) != 4)
+    {
+        return false;
+    }
+    trimName(agent->name);
+    return true;
+}
+
+/**
+ * Returns true if agents can use the strategy
+ */
+static bool validStrategy(int strategy)
+{
+    return strategy == STATIONARY || strategy == RANDOM ||
+           strategy == CHEAPEST_LEAST_VISITED || strategy == DFS ||
+           strategy == GETAWAY_SEEKING || strategy == INFORMANT_SEEKING ||
+           strategy == COORDINATED;
+}
+
+/**
+ * Skips any whitespace and returns true if nothing is left in the file
+ */
+static bool atEndOfFile(FILE *fp)
+{
+    int c = fgetc(fp);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+        c = fgetc(fp);
+    }
+    if (c == EOF)
+    {
+        return true;
+    }
+    ungetc(c, fp);
+    return false;
+}
+
+/**
+ * Returns a pointer to the first character in the string that is not a space
+ */
+static char *skipSpaces(char *s)
+{
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n')
+    {
+        s++;
+    }
+    return s;
+}
+
+/**
+ * Removes trailing whitespace from the name
+ */
+static void trimName(char *name)
+{
+    int len = strlen(name);
+    while (len > 0 && (name[len - 1] == ' ' || name[len - 1] == '\t' ||
+                       name[len - 1] == '\r' || name[len - 1] == '\n'))
+    {
+        name[--len] = '\0';
+    }
+}
+
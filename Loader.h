@@ -0,0 +1,70 @@
+// Interface to the data file loader
+// Reads the city data and agent data files described in README.md.
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+
+#include "Map.h"
+#include "Pool.h"
+
+#define NUM_DETECTIVES 4 // in the original game; data files may have any
+                         // number of detectives
+#define MAX_NAME_LENGTH 100
+
+struct agentData {
+    int stamina;
+    int start;
+    int strategy; // RANDOM for the thief unless the caller changes it
+    char name[MAX_NAME_LENGTH + 1];
+};
+
+struct gameData {
+    struct agentData thief;
+    int getaway;
+    int numDetectives;
+    struct agentData *detectives;
+};
+
+/**
+ * Reads the city data file and returns a new map containing its cities,
+ * roads and informants, or NULL if the file could not be opened or is
+ * malformed. The caller is responsible for freeing the map.
+ */
+Map LoaderReadCities(char *filename);
+
+/**
+ * Reads the city data file like LoaderReadCities and returns the same map,
+ * or NULL in the same cases, but maps the file into memory and parses it in
+ * chunks on the pool's threads (or on the calling thread if the pool is
+ * NULL or the file is small). Anything but a regular file, such as a pipe,
+ * is read by LoaderReadCities instead.
+ * NOTE: Waits for the pool to be idle, so the pool must not be shared with
+ *       other work, including the task that calls this
+ */
+Map LoaderReadCitiesParallel(char *filename, Pool pool);
+
+/**
+ * Reads the agent data file into `data`: the thief and then one or more
+ * detectives, one per line until the end of the file. Returns false if the
+ * file could not be opened or is malformed.
+ * If true is returned, `data->detectives` is newly allocated and must be
+ * freed with LoaderFreeAgents.
+ */
+bool LoaderReadAgents(char *filename, struct gameData *data);
+
+/**
+ * Returns the reason the agents cannot play on the map, or NULL if they
+ * can: every city must be on the map, every stamina positive and every
+ * strategy one that agents of their kind can use
+ */
+char *LoaderCheckAgents(Map m, struct gameData *data);
+
+/**
+ * Frees the detectives read by LoaderReadAgents
+ */
+void LoaderFreeAgents(struct gameData *data);
+
+#endif
+
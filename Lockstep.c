@@ -0,0 +1,477 @@
+// Implementation of the Lockstep ADT
+// The roads are copied into three flat arrays, with each city's roads
+// sorted by the city they lead to, as MapGetRoadsFrom gives them. Each lane
+// plays one game at a time, and the agents' locations, stamina and random
+// number generators are kept agent by agent, with one element per lane.
+// Every step works on all the lanes, with the lanes whose game is over
+// masked out rather than branched around, and a lane whose game finishes
+// takes the next game that has not been played yet.
+//
+// A random move is chosen in two passes over the roads of the lanes'
+// cities: one counts the roads each lane has enough stamina for, and after
+// every lane has drawn its random number, the other picks the road the
+// number falls on. The passes go as far as the longest list of roads, with
+// the lanes whose list is shorter reading their first road again and
+// ignoring it, so the arrays are padded with an extra road for the last
+// city to read when it has none.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Agent.h"
+#include "Game.h"
+#include "Lockstep.h"
+
+struct lockstep
+{
+    int numCities;
+    long *firstRoad; // index of each city's first road, and one past the end
+    int *roadTo;
+    int *roadLength;
+    bool hasInformants;
+};
+
+// The games being played, one per lane
+struct lanes
+{
+    int game[LOCKSTEP_LANES]; // the game in each lane, or -1 for none
+    int live[LOCKSTEP_LANES]; // 1 while the lane's game is running
+    int cycle[LOCKSTEP_LANES];
+    int state[LOCKSTEP_LANES];
+    int *location; // of agent a in lane i at [a * LOCKSTEP_LANES + i]
+    int *stamina;
+    unsigned int *seed;
+};
+
+// The agents every game starts with
+struct agents
+{
+    int numAgents;
+    int *start;
+    int *maxStamina;
+    int *strategy;
+    unsigned int *seedOffset; // added to each game's seed
+};
+
+static void printNullError(void);
+static void readAgents(struct gameData *data, struct agents *agents);
+static void freeAgents(struct agents *agents);
+static bool caughtAtStart(struct agents *agents);
+static void startGame(struct lanes *lanes, int lane, int game,
+                      struct agents *agents, unsigned int seed);
+static void step(Lockstep l, struct lanes *lanes, struct agents *agents,
+                 int getaway, int maxCycles);
+static void moveRandomly(Lockstep l, struct lanes *lanes, int agent,
+                         int maxStamina);
+static void rest(struct lanes *lanes, int agent, int maxStamina);
+static void drawLanes(unsigned int seed[], const int draw[], int r[]);
+
+/**
+ * Copies the map's roads into the flat arrays
+ */
+Lockstep LockstepNew(Map m)
+{
+    Lockstep l = malloc(sizeof(struct lockstep));
+    if (l == NULL)
+    {
+        printNullError();
+    }
+    l->numCities = MapNumCities(m);
+    l->hasInformants = MapNumInformants(m) > 0;
+
+    // every road is in the lists of both its cities
+    long numEntries = 2 * MapNumRoads(m);
+    l->firstRoad = malloc((l->numCities + 1) * sizeof(long));
+    l->roadTo = malloc((numEntries + 1) * sizeof(int));
+    l->roadLength = malloc((numEntries + 1) * sizeof(int));
+    struct road *roads = malloc(l->numCities * sizeof(struct road));
+    if (l->firstRoad == NULL || l->roadTo == NULL || l->roadLength == NULL ||
+        roads == NULL)
+    {
+        printNullError();
+    }
+
+    long next = 0;
+    for (int city = 0; city < l->numCities; city++)
+    {
+        l->firstRoad[city] = next;
+        int numRoads = MapGetRoadsFrom(m, city, roads);
+        for (int i = 0; i < numRoads; i++)
+        {
+            l->roadTo[next] = roads[i].to;
+            l->roadLength[next] = roads[i].length;
+            next++;
+        }
+    }
+    l->firstRoad[l->numCities] = next;
+    l->roadTo[next] = 0;
+    l->roadLength[next] = 0;
+
+    free(roads);
+    return l;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Frees the road arrays and then the player
+ */
+void LockstepFree(Lockstep l)
+{
+    free(l->firstRoad);
+    free(l->roadTo);
+    free(l->roadLength);
+    free(l);
+}
+
+/**
+ * Checks every agent's strategy
+ */
+bool LockstepCanPlay(Lockstep l, struct gameData *data)
+{
+    if (l->hasInformants)
+    {
+        return false;
+    }
+    for (int i = -1; i < data->numDetectives; i++)
+    {
+        int strategy = i < 0 ? data->thief.strategy
+                             : data->detectives[i].strategy;
+        if (strategy != RANDOM && strategy != STATIONARY)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Fills the lanes with the first games, then steps them all until every
+ * game has been played, recording each game as it finishes and starting
+ * the next one in its lane
+ */
+bool LockstepRun(Lockstep l, struct gameData *data, int maxCycles,
+                 const unsigned int seeds[], int numGames, int states[],
+                 int cycles[])
+{
+    if (!LockstepCanPlay(l, data))
+    {
+        return false;
+    }
+    for (int i = -1; i < data->numDetectives; i++)
+    {
+        int start = i < 0 ? data->thief.start : data->detectives[i].start;
+        if (start < 0 || start >= l->numCities)
+        {
+            fprintf(stderr, "error: starting city (%d) is invalid\n", start);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    struct agents agents;
+    readAgents(data, &agents);
+
+    // a detective starting in the thief's city catches it in every game
+    if (caughtAtStart(&agents))
+    {
+        for (int i = 0; i < numGames; i++)
+        {
+            states[i] = GAME_CAUGHT;
+            cycles[i] = 0;
+        }
+        freeAgents(&agents);
+        return true;
+    }
+
+    struct lanes lanes;
+    int numElements = agents.numAgents * LOCKSTEP_LANES;
+    // idle lanes read roads from city 0 until they are given a game
+    lanes.location = calloc(numElements, sizeof(int));
+    lanes.stamina = calloc(numElements, sizeof(int));
+    lanes.seed = calloc(numElements, sizeof(unsigned int));
+    if (lanes.location == NULL || lanes.stamina == NULL || lanes.seed == NULL)
+    {
+        printNullError();
+    }
+
+    int nextGame = 0;
+    int numLive = 0;
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        lanes.game[i] = -1;
+        lanes.live[i] = 0;
+        if (nextGame < numGames)
+        {
+            startGame(&lanes, i, nextGame, &agents, seeds[nextGame]);
+            nextGame++;
+            numLive++;
+        }
+    }
+
+    while (numLive > 0)
+    {
+        step(l, &lanes, &agents, data->getaway, maxCycles);
+        for (int i = 0; i < LOCKSTEP_LANES; i++)
+        {
+            if (lanes.game[i] == -1 || lanes.live[i])
+            {
+                continue;
+            }
+            states[lanes.game[i]] = lanes.state[i];
+            cycles[lanes.game[i]] = lanes.cycle[i];
+            lanes.game[i] = -1;
+            numLive--;
+            if (nextGame < numGames)
+            {
+                startGame(&lanes, i, nextGame, &agents, seeds[nextGame]);
+                nextGame++;
+                numLive++;
+            }
+        }
+    }
+
+    free(lanes.location);
+    free(lanes.stamina);
+    free(lanes.seed);
+    freeAgents(&agents);
+    return true;
+}
+
+/**
+ * Lays the agents out with the thief first, as a game does, and gives each
+ * the same seed offset as GameNew
+ */
+static void readAgents(struct gameData *data, struct agents *agents)
+{
+    int numAgents = data->numDetectives + 1;
+    agents->numAgents = numAgents;
+    agents->start = malloc(numAgents * sizeof(int));
+    agents->maxStamina = malloc(numAgents * sizeof(int));
+    agents->strategy = malloc(numAgents * sizeof(int));
+    agents->seedOffset = malloc(numAgents * sizeof(unsigned int));
+    if (agents->start == NULL || agents->maxStamina == NULL ||
+        agents->strategy == NULL || agents->seedOffset == NULL)
+    {
+        printNullError();
+    }
+
+    for (int i = 0; i < numAgents; i++)
+    {
+        struct agentData *agent = i == 0 ? &data->thief
+                                         : &data->detectives[i - 1];
+        agents->start[i] = agent->start;
+        agents->maxStamina[i] = agent->stamina;
+        agents->strategy[i] = agent->strategy;
+        agents->seedOffset[i] = i * 0x9E3779B9u;
+    }
+}
+
+/**
+ * Frees the agents' arrays
+ */
+static void freeAgents(struct agents *agents)
+{
+    free(agents->start);
+    free(agents->maxStamina);
+    free(agents->strategy);
+    free(agents->seedOffset);
+}
+
+/**
+ * Returns true if a detective starts in the thief's city
+ */
+static bool caughtAtStart(struct agents *agents)
+{
+    for (int i = 1; i < agents->numAgents; i++)
+    {
+        if (agents->start[i] == agents->start[0])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Puts every agent of the game at its start with full stamina
+ */
+static void startGame(struct lanes *lanes, int lane, int game,
+                      struct agents *agents, unsigned int seed)
+{
+    for (int a = 0; a < agents->numAgents; a++)
+    {
+        int i = a * LOCKSTEP_LANES + lane;
+        lanes->location[i] = agents->start[a];
+        lanes->stamina[i] = agents->maxStamina[a];
+        lanes->seed[i] = seed + agents->seedOffset[a];
+    }
+    lanes->game[lane] = game;
+    lanes->live[lane] = 1;
+    lanes->cycle[lane] = 0;
+    lanes->state[lane] = GAME_RUNNING;
+}
+
+/**
+ * Plays one cycle of every live lane's game: moves the agents in order,
+ * then checks for a capture, an escape and the time running out, as
+ * GameStep does
+ */
+static void step(Lockstep l, struct lanes *lanes, struct agents *agents,
+                 int getaway, int maxCycles)
+{
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        lanes->cycle[i] += lanes->live[i];
+    }
+
+    for (int a = 0; a < agents->numAgents; a++)
+    {
+        if (agents->strategy[a] == RANDOM)
+        {
+            moveRandomly(l, lanes, a, agents->maxStamina[a]);
+        }
+        else
+        {
+            rest(lanes, a, agents->maxStamina[a]);
+        }
+    }
+
+    const int *thief = lanes->location;
+    int caught[LOCKSTEP_LANES] = {0};
+    for (int a = 1; a < agents->numAgents; a++)
+    {
+        const int *detective = &lanes->location[a * LOCKSTEP_LANES];
+        for (int i = 0; i < LOCKSTEP_LANES; i++)
+        {
+            caught[i] |= detective[i] == thief[i];
+        }
+    }
+
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        int state = caught[i]                      ? GAME_CAUGHT
+                    : thief[i] == getaway          ? GAME_ESCAPED
+                    : lanes->cycle[i] >= maxCycles ? GAME_COLD
+                                                   : GAME_RUNNING;
+        lanes->state[i] = lanes->live[i] ? state : lanes->state[i];
+        lanes->live[i] &= state == GAME_RUNNING;
+    }
+}
+
+/**
+ * Moves the agent along a random road it has enough stamina for in every
+ * live lane, or rests it where it has none, as chooseRandomMove does
+ */
+static void moveRandomly(Lockstep l, struct lanes *lanes, int agent,
+                         int maxStamina)
+{
+    int *location = &lanes->location[agent * LOCKSTEP_LANES];
+    int *stamina = &lanes->stamina[agent * LOCKSTEP_LANES];
+    unsigned int *seed = &lanes->seed[agent * LOCKSTEP_LANES];
+
+    long first[LOCKSTEP_LANES];
+    int numRoads[LOCKSTEP_LANES];
+    int maxRoads = 0;
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        first[i] = l->firstRoad[location[i]];
+        numRoads[i] = lanes->live[i]
+                          ? (int)(l->firstRoad[location[i] + 1] - first[i])
+                          : 0;
+        maxRoads = numRoads[i] > maxRoads ? numRoads[i] : maxRoads;
+    }
+
+    // count the roads each lane has enough stamina for
+    int numLegal[LOCKSTEP_LANES] = {0};
+    for (int j = 0; j < maxRoads; j++)
+    {
+        for (int i = 0; i < LOCKSTEP_LANES; i++)
+        {
+            long road = first[i] + (j < numRoads[i] ? j : 0);
+            numLegal[i] += j < numRoads[i] &&
+                           l->roadLength[road] <= stamina[i];
+        }
+    }
+
+    // only lanes with somewhere to go use up a random number
+    int draw[LOCKSTEP_LANES];
+    int r[LOCKSTEP_LANES];
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        draw[i] = numLegal[i] > 0;
+    }
+    drawLanes(seed, draw, r);
+
+    int k[LOCKSTEP_LANES];
+    int to[LOCKSTEP_LANES];
+    int cost[LOCKSTEP_LANES];
+    int seen[LOCKSTEP_LANES] = {0};
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        k[i] = draw[i] ? r[i] % numLegal[i] : -1;
+        to[i] = location[i];
+        cost[i] = 0;
+    }
+
+    // pick the k-th road each lane has enough stamina for
+    for (int j = 0; j < maxRoads; j++)
+    {
+        for (int i = 0; i < LOCKSTEP_LANES; i++)
+        {
+            long road = first[i] + (j < numRoads[i] ? j : 0);
+            int legal = j < numRoads[i] && l->roadLength[road] <= stamina[i];
+            int hit = legal && seen[i] == k[i];
+            to[i] = hit ? l->roadTo[road] : to[i];
+            cost[i] = hit ? l->roadLength[road] : cost[i];
+            seen[i] += legal;
+        }
+    }
+
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        int moved = to[i] == location[i] ? maxStamina : stamina[i] - cost[i];
+        stamina[i] = lanes->live[i] ? moved : stamina[i];
+        location[i] = to[i];
+    }
+}
+
+/**
+ * Rests the agent in every live lane, which restores its stamina
+ */
+static void rest(struct lanes *lanes, int agent, int maxStamina)
+{
+    int *stamina = &lanes->stamina[agent * LOCKSTEP_LANES];
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        stamina[i] = lanes->live[i] ? maxStamina : stamina[i];
+    }
+}
+
+/**
+ * Takes the next number from every lane's generator, which works like the
+ * GNU C library's rand_r: three steps of a linear congruential generator
+ * whose top bits are joined into one 31-bit number. The generators of the
+ * lanes that are not drawing are left as they were.
+ */
+static void drawLanes(unsigned int seed[], const int draw[], int r[])
+{
+    for (int i = 0; i < LOCKSTEP_LANES; i++)
+    {
+        unsigned int next = seed[i];
+        next = next * 1103515245u + 12345u;
+        unsigned int result = (next / 65536) % 2048;
+        next = next * 1103515245u + 12345u;
+        result = (result << 10) ^ ((next / 65536) % 1024);
+        next = next * 1103515245u + 12345u;
+        result = (result << 10) ^ ((next / 65536) % 1024);
+        seed[i] = draw[i] ? next : seed[i];
+        r[i] = (int)result;
+    }
+}
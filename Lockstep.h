@@ -0,0 +1,55 @@
+// Interface to the Lockstep ADT
+// Plays many games with the same agents on the same map and different
+// seeds, a group of games at a time, moving every game in the group one
+// cycle on with each pass over the agents. The games' state is kept in
+// arrays with one element per game, so the work of a cycle (drawing the
+// random numbers, filtering roads by stamina, checking for a capture) is
+// done by loops over the group which the compiler can turn into vector
+// instructions, rather than by branchy code for one game at a time.
+// Only games in which every agent moves at random or stays put, on a map
+// with no informants, can be played this way.
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stdbool.h>
+
+#include "Loader.h"
+#include "Map.h"
+
+#define LOCKSTEP_LANES 16 // games played side by side
+
+typedef struct lockstep *Lockstep;
+
+/**
+ * Creates a lockstep player for the given map. It takes its own copy of the
+ * roads, so later changes to the map are not seen.
+ */
+Lockstep LockstepNew(Map m);
+
+/**
+ * Frees all memory allocated to the lockstep player
+ */
+void LockstepFree(Lockstep l);
+
+/**
+ * Returns true if games with the agents described by `data` can be played
+ * in lockstep: every agent uses the RANDOM or STATIONARY strategy and the
+ * map has no informants
+ */
+bool LockstepCanPlay(Lockstep l, struct gameData *data);
+
+/**
+ * Plays `numGames` games with the agents described by `data`, game i with
+ * seed `seeds[i]`, and stores how each one finished (one of the GAME_*
+ * states in Game.h) in `states[i]` and the number of cycles it took in
+ * `cycles[i]`. Every game plays out exactly as it would with GameNew and
+ * GameRun, given the GNU C library's rand_r, which the agents use.
+ * Returns false without playing anything if LockstepCanPlay is false.
+ * Several threads can play games with the same player at once.
+ */
+bool LockstepRun(Lockstep l, struct gameData *data, int maxCycles,
+                 const unsigned int seeds[], int numGames, int states[],
+                 int cycles[]);
+
+#endif
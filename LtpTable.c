@@ -0,0 +1,283 @@
+// Implementation of the LtpTable ADT
+// The table is one search from every city, stored as an array of entries
+// indexed by [destination * numCities + city].
+//
+// A saved table is a header followed by the entries, in the byte order of
+// the machine that saved it:
+//  - the bytes "LTPT"
+//  - the file format version (32 bits)
+//  - the number of cities (32 bits)
+//  - the maximum stamina (32 bits)
+//  - MapHash of the map the table was built for (64 bits)
+//  - a checksum of the entries: 64-bit FNV-1a over their 32-bit fields
+// A loaded table points straight into the mapped file.
+
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Agent.h"
+#include "LeastTurns.h"
+#include "LtpTable.h"
+#include "Map.h"
+
+#define FILE_VERSION 1
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+struct header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numCities;
+    uint32_t stamina;
+    uint64_t mapHash;
+    uint64_t checksum;
+};
+
+struct entry
+{
+    int32_t next; // the next city, or -1
+    int32_t staminaCost;
+    int32_t turns; // -1 if the destination cannot be reached
+};
+
+struct ltpTable
+{
+    int numCities;
+    int stamina;
+    uint64_t mapHash;
+    struct entry *entries;
+
+    // the map the table is for and the version of its roads
+    Map map;
+    unsigned long mapVersion;
+
+    // the mapped file for a loaded table, or NULL for a built one
+    void *mapping;
+    size_t mappingSize;
+};
+
+static void printNullError(void);
+static LtpTable newTable(Map m, int stamina);
+static uint64_t checksum(struct entry *entries, size_t numEntries);
+static size_t numEntries(LtpTable t);
+
+/**
+ * Runs a least turns search with full stamina from every city and keeps the
+ * first move and number of turns from every other city
+ */
+LtpTable LtpTableBuild(Map m, int stamina)
+{
+    LtpTable t = newTable(m, stamina);
+    t->entries = malloc(numEntries(t) * sizeof(struct entry));
+    struct costedMove *labels = malloc(t->numCities *
+                                       sizeof(struct costedMove));
+    if (t->entries == NULL || labels == NULL)
+    {
+        printNullError();
+    }
+
+    for (int to = 0; to < t->numCities; to++)
+    {
+        LeastTurnsSearch(m, to, stamina, stamina, labels);
+        struct entry *row = &t->entries[(size_t)to * t->numCities];
+        for (int from = 0; from < t->numCities; from++)
+        {
+            bool reachable = labels[from].numMovesTaken != INT_MAX;
+            row[from] = (struct entry){labels[from].m.to,
+                                       labels[from].m.staminaCost,
+                                       reachable ? labels[from].numMovesTaken
+                                                 : -1};
+        }
+    }
+
+    free(labels);
+    return t;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Creates a table with no entries for the given map and stamina
+ */
+static LtpTable newTable(Map m, int stamina)
+{
+    LtpTable t = malloc(sizeof(struct ltpTable));
+    if (t == NULL)
+    {
+        printNullError();
+    }
+    t->numCities = MapNumCities(m);
+    t->stamina = stamina;
+    t->mapHash = MapHash(m);
+    t->entries = NULL;
+    t->map = m;
+    t->mapVersion = MapVersion(m);
+    t->mapping = NULL;
+    t->mappingSize = 0;
+    return t;
+}
+
+/**
+ * Writes the header and then the entries
+ */
+bool LtpTableSave(LtpTable t, char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+
+    struct header h = {{'L', 'T', 'P', 'T'}, FILE_VERSION, t->numCities,
+                       t->stamina, t->mapHash,
+                       checksum(t->entries, numEntries(t))};
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+              fwrite(t->entries, sizeof(struct entry), numEntries(t), fp) ==
+                  numEntries(t);
+    if (fclose(fp) != 0)
+    {
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * Maps the file into memory and checks its header and checksum before
+ * using its entries
+ */
+LtpTable LtpTableLoad(Map m, int stamina, char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct header))
+    {
+        close(fd);
+        return NULL;
+    }
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    struct header *h = mapping;
+    struct entry *entries = (struct entry *)(h + 1);
+    size_t numCities = MapNumCities(m);
+    bool valid = memcmp(h->magic, "LTPT", 4) == 0 &&
+                 h->version == FILE_VERSION &&
+                 h->numCities == numCities &&
+                 h->stamina == (uint32_t)stamina &&
+                 h->mapHash == MapHash(m) &&
+                 (size_t)st.st_size == sizeof(struct header) + numCities *
+                                       numCities * sizeof(struct entry) &&
+                 h->checksum == checksum(entries, numCities * numCities);
+    if (!valid)
+    {
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+
+    LtpTable t = newTable(m, stamina);
+    t->entries = entries;
+    t->mapping = mapping;
+    t->mappingSize = st.st_size;
+    return t;
+}
+
+/**
+ * Unmaps a loaded table's file or frees a built table's entries
+ */
+void LtpTableFree(LtpTable t)
+{
+    if (t->mapping != NULL)
+    {
+        munmap(t->mapping, t->mappingSize);
+    }
+    else
+    {
+        free(t->entries);
+    }
+    free(t);
+}
+
+/**
+ * Returns the maximum stamina of the table
+ */
+int LtpTableStamina(LtpTable t)
+{
+    return t->stamina;
+}
+
+/**
+ * Checks that the table is for this map and its roads are unchanged
+ */
+bool LtpTableIsCurrent(LtpTable t, Map m)
+{
+    return t->map == m && t->mapVersion == MapVersion(m);
+}
+
+/**
+ * Looks up the first move from `from` towards `to`
+ */
+struct move LtpTableNextMove(LtpTable t, int from, int to)
+{
+    assert(from >= 0 && from < t->numCities && to >= 0 && to < t->numCities);
+    struct entry e = t->entries[(size_t)to * t->numCities + from];
+    return (struct move){e.next, e.staminaCost};
+}
+
+/**
+ * Looks up the number of turns from `from` to `to`
+ */
+int LtpTableTurns(LtpTable t, int from, int to)
+{
+    assert(from >= 0 && from < t->numCities && to >= 0 && to < t->numCities);
+    return t->entries[(size_t)to * t->numCities + from].turns;
+}
+
+/**
+ * Returns the 64-bit FNV-1a hash of the entries, taken a field at a time
+ * rather than a byte at a time
+ */
+static uint64_t checksum(struct entry *entries, size_t numEntries)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        hash = (hash ^ (uint32_t)entries[i].next) * FNV_PRIME;
+        hash = (hash ^ (uint32_t)entries[i].staminaCost) * FNV_PRIME;
+        hash = (hash ^ (uint32_t)entries[i].turns) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Returns the number of entries in the table
+ */
+static size_t numEntries(LtpTable t)
+{
+    return (size_t)t->numCities * t->numCities;
+}
+
@@ -0,0 +1,74 @@
+// Interface to the LtpTable ADT
+// A least turns table holds, for one map and one maximum stamina, the next
+// road to take from every city towards every other city on a least turns
+// path, along with the number of turns the path takes, for an agent that
+// sets out with full stamina. The paths are the ones found by a least turns
+// search from the destination city, the same paths that AgentTipOffAll
+// gives agents at full stamina. An agent with less stamina may need more
+// turns on them than on a path of its own, so it should search instead.
+//
+// Building a table takes one search per city, so tables can be saved to a
+// file and loaded (by mapping the file into memory) on later runs. A table
+// takes 12 bytes for every pair of cities.
+
+#ifndef LTP_TABLE_H
+#define LTP_TABLE_H
+
+#include <stdbool.h>
+
+#include "Agent.h"
+#include "Map.h"
+
+// The LtpTable type is declared in Agent.h
+
+/**
+ * Builds the table for the given map and maximum stamina
+ */
+LtpTable LtpTableBuild(Map m, int stamina);
+
+/**
+ * Saves the table to the given file, returning false if it could not be
+ * written
+ */
+bool LtpTableSave(LtpTable t, char *filename);
+
+/**
+ * Loads a table saved by LtpTableSave for the given map and maximum stamina.
+ * Returns NULL if the file cannot be read, was saved by a different version
+ * of this program, was built for a different map or stamina, or fails its
+ * checksum.
+ */
+LtpTable LtpTableLoad(Map m, int stamina, char *filename);
+
+/**
+ * Frees all memory allocated to the table
+ */
+void LtpTableFree(LtpTable t);
+
+/**
+ * Returns the maximum stamina the table was built for
+ */
+int LtpTableStamina(LtpTable t);
+
+/**
+ * Returns true if the table was built or loaded for the given map and the
+ * map's roads have not changed since
+ */
+bool LtpTableIsCurrent(LtpTable t, Map m);
+
+/**
+ * Returns the first move on the least turns path from `from` to `to` for an
+ * agent that sets out with full stamina, or a move to -1 if `from` is `to`
+ * or `to` cannot be reached
+ */
+struct move LtpTableNextMove(LtpTable t, int from, int to);
+
+/**
+ * Returns the number of turns the least turns path from `from` to `to`
+ * takes for an agent that sets out with full stamina, or -1 if `to` cannot
+ * be reached
+ */
+int LtpTableTurns(LtpTable t, int from, int to);
+
+#endif
+
@@ -8,72 +8,167 @@
 //    This code was adapted from GraphAdjList.c program code from the lectures.
 //    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
 //    Frees all the roads, names and the map itself.
-//  - adjListInsert
-//    This code was adapted from GraphAdjList.c program code from the lectures.
-//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
-//    Creates a new road and adds it into the map.
-//  - newAdjNode
-//    This code was adapted from GraphAdjList.c program code from the lectures.
-//    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
-//    Creates a new road for the map.
 //  - MapContainsRoad
 //    This code was adapted from GraphAdjList.c program code from the lectures.
 //    Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
 //   Checks if the road is already in the map.
+//
+// Every city's roads are kept sorted by length, with ties sorted by the city
+// at the other end, and encoded into one array of bytes shared by all the
+// cities. Each road is two variable-length numbers of 7 bits a byte: the
+// difference between its length and the length of the road before it, which
+// is small (usually 0) since the lengths are sorted, and the difference
+// between the city it goes to and the city the road before it goes to (or
+// the city itself for the first road), with its sign folded into the lowest
+// bit. Most roads take two to four bytes instead of the dozens a list node
+// and a sorted copy took.
+//
+// A city's bytes have some room to spare after them. A change to a city's
+// roads re-encodes them in place if they still fit, and otherwise moves them
+// to the end of the array with twice the room, leaving a hole. When the
+// array is full, every city's roads are copied to the front of a new array
+// without the holes.
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "Allocator.h"
 #include "Map.h"
 
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+#define WORD_BITS 64
+#define INITIAL_BYTES 64
+
 static void printNullError(void);
+static uint64_t hashInt(uint64_t hash, int n);
 
-static struct adjNode *adjListInsert(struct adjNode *r, int city, int length);
-static struct adjNode *newAdjNode(int city, int length);
+static void rewriteRoads(Map m, int city, int to, int length);
+static void encodeRoad(Map m, struct road *prev, int to, int length);
+static void putVarint(Map m, uint64_t value);
+static const uint8_t *getVarint(const uint8_t *p, uint64_t *value);
+static void storeRoads(Map m, int city, int numRoads);
+static uint64_t reserveBytes(Map m, uint64_t numBytes);
+static void packRoads(Map m, Map from, uint64_t size);
+static int compareTo(const void *a, const void *b);
+static int compareLength(const void *a, const void *b);
 
-struct adjNode
+// Where a city's roads are in the map's array of bytes
+struct cityRoads
 {
-    int city;
-    int length;
-    struct adjNode *next;
+    uint64_t offset;
+    uint64_t numBytes;
+    uint64_t room; // bytes the roads may take before they must move
+    int numRoads;
 };
 
 struct map
 {
+    Allocator allocator; // everything the map holds comes from here
     int numCities;
-    int numRoads;
+    long numRoads;
+    unsigned long version;
+    unsigned long informantVersion;
     char **names;
-    struct adjNode **roads;
+    uint64_t *informants; // one bit per city
+    int numInformants;
+
+    struct cityRoads *cities;
+    uint8_t *bytes;
+    uint64_t numBytes; // the end of the last city's room
+    uint64_t size;     // of the array
+
+    // where a city's roads are re-encoded before they are stored
+    uint8_t *scratch;
+    size_t scratchLength;
+    size_t scratchSize;
 };
 
 /**
- * Creates a new map and allocating all the memory that is needed for a map
+ * Creates a new map whose memory comes from malloc
  */
 Map MapNew(int numCities)
 {
-    Map m = malloc(sizeof(struct map));
+    return MapNewWithAllocator(numCities, NULL);
+}
+
+/**
+ * Creates a new map and allocating all the memory that is needed for a map
+ */
+Map MapNewWithAllocator(int numCities, Allocator allocator)
+{
+    Map m = AllocatorMalloc(allocator, sizeof(struct map));
     if (m == NULL)
     {
         printNullError();
     }
+    m->allocator = allocator;
     m->numCities = numCities;
     m->numRoads = 0;
-    m->names = calloc(numCities, sizeof(char *));
+    m->version = 0;
+    m->informantVersion = 0;
+    m->names = AllocatorCalloc(allocator, numCities, sizeof(char *));
     if (m->names == NULL)
     {
         printNullError();
     }
-    m->roads = calloc(numCities, sizeof(struct adjNode *));
-    if (m->roads == NULL)
+    m->informants = AllocatorCalloc(allocator,
+                                    (numCities + WORD_BITS - 1) / WORD_BITS,
+                                    sizeof(uint64_t));
+    m->numInformants = 0;
+    m->cities = AllocatorCalloc(allocator, numCities,
+                                sizeof(struct cityRoads));
+    if (m->informants == NULL || m->cities == NULL)
+    {
+        printNullError();
+    }
+    m->size = INITIAL_BYTES;
+    m->bytes = AllocatorMalloc(allocator, m->size);
+    if (m->bytes == NULL)
     {
         printNullError();
     }
+    m->numBytes = 0;
+    m->scratch = NULL;
+    m->scratchLength = 0;
+    m->scratchSize = 0;
     return m;
 }
 
+/**
+ * Makes a new map and copies the names, informants and roads into it, with
+ * the roads packed together as they are after the array fills up
+ */
+Map MapCopy(Map m, Allocator allocator)
+{
+    Map copy = MapNewWithAllocator(m->numCities, allocator);
+    for (int city = 0; city < m->numCities; city++)
+    {
+        if (m->names[city] != NULL)
+        {
+            MapSetName(copy, city, m->names[city]);
+        }
+    }
+    memcpy(copy->informants, m->informants,
+           (m->numCities + WORD_BITS - 1) / WORD_BITS * sizeof(uint64_t));
+    copy->numInformants = m->numInformants;
+
+    uint64_t inUse = 0;
+    for (int city = 0; city < m->numCities; city++)
+    {
+        inUse += m->cities[city].numBytes;
+    }
+    packRoads(copy, m, inUse);
+    copy->numRoads = m->numRoads;
+    copy->version = m->version;
+    copy->informantVersion = m->informantVersion;
+    return copy;
+}
+
 /**
  * Prints an error message if memory cannot be allocated and exits the program
  */
@@ -92,18 +187,14 @@ void MapFree(Map m)
 {
     for (int i = 0; i < m->numCities; i++)
     {
-        free(m->names[i]);
-        struct adjNode *curr = m->roads[i];
-        while (curr != NULL)
-        {
-            struct adjNode *temp = curr;
-            curr = curr->next;
-            free(temp);
-        }
+        AllocatorRelease(m->allocator, m->names[i]);
     }
-    free(m->names);
-    free(m->roads);
-    free(m);
+    AllocatorRelease(m->allocator, m->names);
+    AllocatorRelease(m->allocator, m->informants);
+    AllocatorRelease(m->allocator, m->cities);
+    AllocatorRelease(m->allocator, m->bytes);
+    AllocatorRelease(m->allocator, m->scratch);
+    AllocatorRelease(m->allocator, m);
 }
 
 /**
@@ -117,11 +208,19 @@ int MapNumCities(Map m)
 /**
  * Returns the number of roads that is in the map given
  */
-int MapNumRoads(Map m)
+long MapNumRoads(Map m)
 {
     return m->numRoads;
 }
 
+/**
+ * Returns the number of roads the city has
+ */
+int MapNumRoadsFrom(Map m, int city)
+{
+    return m->cities[city].numRoads;
+}
+
 /**
  * Sets the city's name if it's empty and replaces the name if it has an old
  * name
@@ -130,16 +229,26 @@ void MapSetName(Map m, int city, char *name)
 {
     if (m->names[city] == NULL)
     {
-        m->names[city] = strdup(name);
+        m->names[city] = AllocatorStrdup(m->allocator, name);
         if (m->names[city] == NULL)
         {
             printNullError();
         }
     }
-    else
+    else if (strlen(name) <= strlen(m->names[city]))
     {
         strcpy(m->names[city], name);
     }
+    else
+    {
+        // the old name's memory is too small for the new one
+        AllocatorRelease(m->allocator, m->names[city]);
+        m->names[city] = AllocatorStrdup(m->allocator, name);
+        if (m->names[city] == NULL)
+        {
+            printNullError();
+        }
+    }
 }
 
 /**
@@ -157,6 +266,37 @@ char *MapGetName(Map m, int city)
     }
 }
 
+/**
+ * Sets or clears the city's bit and counts the change
+ */
+void MapSetInformant(Map m, int city, bool hasInformant)
+{
+    assert(city >= 0 && city < m->numCities);
+    if (MapHasInformant(m, city) != hasInformant)
+    {
+        m->informants[city / WORD_BITS] ^= (uint64_t)1 << (city % WORD_BITS);
+        m->numInformants += hasInformant ? 1 : -1;
+        m->informantVersion++;
+    }
+}
+
+/**
+ * Returns the city's bit
+ */
+bool MapHasInformant(Map m, int city)
+{
+    assert(city >= 0 && city < m->numCities);
+    return (m->informants[city / WORD_BITS] >> (city % WORD_BITS)) & 1;
+}
+
+/**
+ * Returns the number of cities whose bit is set
+ */
+int MapNumInformants(Map m)
+{
+    return m->numInformants;
+}
+
 /**
  * Inserts a road between two cities if there was no road
  */
@@ -164,52 +304,355 @@ void MapInsertRoad(Map m, int city1, int city2, int length)
 {
     if (MapContainsRoad(m, city1, city2) == 0)
     {
-        m->roads[city1] = adjListInsert(m->roads[city1], city2, length);
-        m->roads[city2] = adjListInsert(m->roads[city2], city1, length);
+        rewriteRoads(m, city1, city2, length);
+        rewriteRoads(m, city2, city1, length);
         m->numRoads++;
+        m->version++;
     }
 }
 
 /**
- * This code was adapted from GraphAdjList.c program code from the lectures.
- * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
- * Creates a new road and adds it into the map.
+ * Groups both ends of every road by city in the order they are given, keeps
+ * each city's first road to any other city, then sorts and encodes every
+ * city's roads. The first of several roads between two cities is the same
+ * one from both ends, so both agree on its length.
  */
-static struct adjNode *adjListInsert(struct adjNode *r, int city, int length)
+void MapInsertRoads(Map m, struct road roads[], long numRoads)
 {
-    if (r == NULL || city < r->city)
+    if (m->numRoads > 0)
     {
-        struct adjNode *new = newAdjNode(city, length);
-        new->next = r;
-        return new;
+        for (long i = 0; i < numRoads; i++)
+        {
+            MapInsertRoad(m, roads[i].from, roads[i].to, roads[i].length);
+        }
+        return;
     }
-    else if (city == r->city)
+
+    long *start = calloc(m->numCities + 1, sizeof(long));
+    struct road *ends = malloc(2 * numRoads * sizeof(struct road));
+    int *lastFrom = malloc(m->numCities * sizeof(int));
+    if (start == NULL || ends == NULL || lastFrom == NULL)
     {
-        return r;
+        printNullError();
     }
-    else
+    for (long i = 0; i < numRoads; i++)
+    {
+        assert(roads[i].from != roads[i].to && roads[i].length > 0);
+        start[roads[i].from + 1]++;
+        start[roads[i].to + 1]++;
+    }
+    for (int city = 0; city < m->numCities; city++)
+    {
+        start[city + 1] += start[city];
+        lastFrom[city] = -1;
+    }
+    for (long i = 0; i < numRoads; i++)
     {
-        r->next = adjListInsert(r->next, city, length);
-        return r;
+        struct road r = roads[i];
+        ends[start[r.from]++] = r;
+        ends[start[r.to]++] = (struct road){r.to, r.from, r.length};
     }
+
+    long numEnds = 0;
+    long first = 0;
+    for (int city = 0; city < m->numCities; city++)
+    {
+        // start[city] is now the end of the city's roads
+        int numKept = 0;
+        for (long i = first; i < start[city]; i++)
+        {
+            if (lastFrom[ends[i].to] != city)
+            {
+                lastFrom[ends[i].to] = city;
+                ends[first + numKept++] = ends[i];
+            }
+        }
+        qsort(&ends[first], numKept, sizeof(struct road), compareLength);
+
+        m->scratchLength = 0;
+        struct road prev = {city, city, 0};
+        for (int i = 0; i < numKept; i++)
+        {
+            encodeRoad(m, &prev, ends[first + i].to, ends[first + i].length);
+        }
+        struct cityRoads *c = &m->cities[city];
+        c->offset = reserveBytes(m, m->scratchLength);
+        memcpy(m->bytes + c->offset, m->scratch, m->scratchLength);
+        c->numBytes = m->scratchLength;
+        c->room = m->scratchLength;
+        c->numRoads = numKept;
+
+        numEnds += numKept;
+        first = start[city];
+    }
+    m->numRoads = numEnds / 2;
+    m->version += numEnds / 2;
+
+    free(start);
+    free(ends);
+    free(lastFrom);
 }
 
 /**
- * This code was adapted from GraphAdjList.c program code from the lectures.
- * Link: https://cgi.cse.unsw.edu.au/~cs2521/24T3/lectures/code/week4_graph/GraphAdjList.c
- * Creates a new road for the map.
+ * Removes the road between two cities if there is one
+ */
+void MapRemoveRoad(Map m, int city1, int city2)
+{
+    if (MapContainsRoad(m, city1, city2) != 0)
+    {
+        rewriteRoads(m, city1, city2, 0);
+        rewriteRoads(m, city2, city1, 0);
+        m->numRoads--;
+        m->version++;
+    }
+}
+
+/**
+ * Changes the length of the road in both directions if there is one
+ */
+void MapSetRoadLength(Map m, int city1, int city2, int length)
+{
+    int oldLength = MapContainsRoad(m, city1, city2);
+    if (oldLength != 0 && oldLength != length)
+    {
+        rewriteRoads(m, city1, city2, length);
+        rewriteRoads(m, city2, city1, length);
+        m->version++;
+    }
+}
+
+/**
+ * Returns the version of the map's roads
+ */
+unsigned long MapVersion(Map m)
+{
+    return m->version;
+}
+
+/**
+ * Returns the version of the map's informants
+ */
+unsigned long MapInformantVersion(Map m)
+{
+    return m->informantVersion;
+}
+
+/**
+ * Re-encodes the city's roads into the scratch array without its road to
+ * `to`, if it has one, and with a road of the given length to `to` in its
+ * place in the order unless the length is 0, then stores them
+ */
+static void rewriteRoads(Map m, int city, int to, int length)
+{
+    m->scratchLength = 0;
+    struct road prev = {city, city, 0};
+    int numRoads = 0;
+    bool inserted = length == 0;
+
+    struct roadIterator it;
+    MapIterateRoads(m, city, &it);
+    struct road r;
+    while (MapNextRoad(&it, &r))
+    {
+        if (!inserted &&
+            (r.length > length || (r.length == length && r.to > to)))
+        {
+            encodeRoad(m, &prev, to, length);
+            numRoads++;
+            inserted = true;
+        }
+        if (r.to != to)
+        {
+            encodeRoad(m, &prev, r.to, r.length);
+            numRoads++;
+        }
+    }
+    if (!inserted)
+    {
+        encodeRoad(m, &prev, to, length);
+        numRoads++;
+    }
+    storeRoads(m, city, numRoads);
+}
+
+/**
+ * Adds a road to the scratch array, following the road `prev`, which then
+ * becomes the new road
+ */
+static void encodeRoad(Map m, struct road *prev, int to, int length)
+{
+    assert(length >= prev->length);
+    int64_t difference = (int64_t)to - prev->to;
+    putVarint(m, length - prev->length);
+    // folds the sign into the lowest bit so that small differences either
+    // way take few bytes
+    putVarint(m, difference >= 0 ? (uint64_t)difference * 2
+                                 : (uint64_t)(-difference) * 2 - 1);
+    prev->to = to;
+    prev->length = length;
+}
+
+/**
+ * Adds a number to the scratch array 7 bits at a time, lowest bits first,
+ * with the top bit of each byte set if more bytes follow
+ */
+static void putVarint(Map m, uint64_t value)
+{
+    // a 64-bit number takes at most 10 bytes
+    if (m->scratchLength + 10 > m->scratchSize)
+    {
+        m->scratchSize = m->scratchSize == 0 ? 64 : m->scratchSize * 2;
+        m->scratch = AllocatorRealloc(m->allocator, m->scratch,
+                                      m->scratchSize);
+        if (m->scratch == NULL)
+        {
+            printNullError();
+        }
+    }
+    while (value >= 0x80)
+    {
+        m->scratch[m->scratchLength++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    m->scratch[m->scratchLength++] = value;
+}
+
+/**
+ * Reads a number written by putVarint and returns the byte after it
+ */
+static const uint8_t *getVarint(const uint8_t *p, uint64_t *value)
+{
+    uint64_t result = 0;
+    int shift = 0;
+    while (*p & 0x80)
+    {
+        result |= (uint64_t)(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    *value = result | (uint64_t)*p++ << shift;
+    return p;
+}
+
+/**
+ * Copies the roads in the scratch array into the city's room, moving them
+ * to the end of the array with twice the room they need if they do not fit
+ */
+static void storeRoads(Map m, int city, int numRoads)
+{
+    struct cityRoads *c = &m->cities[city];
+    if (m->scratchLength > c->room)
+    {
+        // the old roads are in the scratch array, so the city can give up
+        // its room before the array is compacted
+        c->numBytes = 0;
+        c->room = 0;
+        c->offset = reserveBytes(m, 2 * m->scratchLength);
+        c->room = 2 * m->scratchLength;
+    }
+    memcpy(m->bytes + c->offset, m->scratch, m->scratchLength);
+    c->numBytes = m->scratchLength;
+    c->numRoads = numRoads;
+}
+
+/**
+ * Returns the offset of `numBytes` new bytes at the end of the array. If
+ * the array is full, first moves every city's roads to a new array with as
+ * much space again to grow into.
+ */
+static uint64_t reserveBytes(Map m, uint64_t numBytes)
+{
+    if (m->numBytes + numBytes > m->size)
+    {
+        uint64_t inUse = 0;
+        for (int city = 0; city < m->numCities; city++)
+        {
+            inUse += m->cities[city].numBytes;
+        }
+        packRoads(m, m, 2 * (inUse + numBytes));
+    }
+
+    uint64_t offset = m->numBytes;
+    m->numBytes += numBytes;
+    return offset;
+}
+
+/**
+ * Gives the map a new array of (at least) `size` bytes with the roads of
+ * `from`, which may be the same map, copied in order to the front of it,
+ * leaving out the holes and every city's spare room
+ */
+static void packRoads(Map m, Map from, uint64_t size)
+{
+    size = size > INITIAL_BYTES ? size : INITIAL_BYTES;
+    uint8_t *bytes = AllocatorMalloc(m->allocator, size);
+    if (bytes == NULL)
+    {
+        printNullError();
+    }
+
+    uint64_t offset = 0;
+    for (int city = 0; city < m->numCities; city++)
+    {
+        struct cityRoads c = from->cities[city];
+        memcpy(bytes + offset, from->bytes + c.offset, c.numBytes);
+        m->cities[city] = (struct cityRoads){offset, c.numBytes, c.numBytes,
+                                             c.numRoads};
+        offset += c.numBytes;
+    }
+    AllocatorRelease(m->allocator, m->bytes);
+    m->bytes = bytes;
+    m->numBytes = offset;
+    m->size = size;
+}
+
+/**
+ * Hashes the number of cities and then every city's roads in order using
+ * 64-bit FNV-1a
  */
-static struct adjNode *newAdjNode(int city, int length)
+uint64_t MapHash(Map m)
 {
-    struct adjNode *new = malloc(sizeof(struct adjNode));
-    if (new == NULL)
+    int maxRoads = 0;
+    for (int i = 0; i < m->numCities; i++)
+    {
+        if (m->cities[i].numRoads > maxRoads)
+        {
+            maxRoads = m->cities[i].numRoads;
+        }
+    }
+    struct road *roads = malloc((maxRoads + 1) * sizeof(struct road));
+    if (roads == NULL)
     {
         printNullError();
     }
-    new->city = city;
-    new->length = length;
-    new->next = NULL;
-    return new;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = hashInt(hash, m->numCities);
+    for (int i = 0; i < m->numCities; i++)
+    {
+        int numRoads = MapGetRoadsFrom(m, i, roads);
+        for (int j = 0; j < numRoads; j++)
+        {
+            hash = hashInt(hash, roads[j].to);
+            hash = hashInt(hash, roads[j].length);
+        }
+        // marks the end of the city's roads
+        hash = hashInt(hash, -1);
+    }
+    free(roads);
+    return hash;
+}
+
+/**
+ * Adds the four bytes of the number to the FNV-1a hash
+ */
+static uint64_t hashInt(uint64_t hash, int n)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        hash ^= (n >> (8 * i)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+    return hash;
 }
 
 /**
@@ -219,12 +662,14 @@ static struct adjNode *newAdjNode(int city, int length)
  */
 int MapContainsRoad(Map m, int city1, int city2)
 {
-    struct adjNode *curr = m->roads[city1];
-    for (; curr != NULL && city2 >= curr->city; curr = curr->next)
+    struct roadIterator it;
+    MapIterateRoads(m, city1, &it);
+    struct road r;
+    while (MapNextRoad(&it, &r))
     {
-        if (curr->city == city2)
+        if (r.to == city2)
         {
-            return curr->length;
+            return r.length;
         }
     }
     return 0;
@@ -236,26 +681,104 @@ int MapContainsRoad(Map m, int city1, int city2)
  */
 int MapGetRoadsFrom(Map m, int city, struct road roads[])
 {
-    struct adjNode *curr = m->roads[city];
+    struct roadIterator it;
+    MapIterateRoads(m, city, &it);
     int roadIndex = 0;
-    while (curr != NULL)
+    while (MapNextRoad(&it, &roads[roadIndex]))
     {
-        struct road r = {city, curr->city, curr->length};
-        roads[roadIndex] = r;
         roadIndex++;
-        curr = curr->next;
     }
+    // the roads are stored by length, so they are sorted again by city
+    qsort(roads, roadIndex, sizeof(struct road), compareTo);
     return roadIndex;
 }
 
 /**
- * !!! DO NOT EDIT THIS FUNCTION !!!
- * This function will work once the other functions are working
+ * Decodes the city's roads up to the first one longer than maxLength
+ */
+int MapGetRoadsByLength(Map m, int city, int maxLength, struct road roads[])
+{
+    struct roadIterator it;
+    MapIterateRoads(m, city, &it);
+    int numRoads = 0;
+    while (MapNextRoad(&it, &roads[numRoads]) &&
+           roads[numRoads].length <= maxLength)
+    {
+        numRoads++;
+    }
+    return numRoads;
+}
+
+/**
+ * Points the iterator at the city's bytes
+ */
+void MapIterateRoads(Map m, int city, struct roadIterator *it)
+{
+    struct cityRoads *c = &m->cities[city];
+    it->next = m->bytes + c->offset;
+    it->end = it->next + c->numBytes;
+    it->from = city;
+    it->to = city;
+    it->length = 0;
+}
+
+/**
+ * Decodes the road at the iterator and moves past it
+ */
+bool MapNextRoad(struct roadIterator *it, struct road *road)
+{
+    if (it->next == it->end)
+    {
+        return false;
+    }
+    uint64_t lengthDifference;
+    uint64_t toDifference;
+    it->next = getVarint(it->next, &lengthDifference);
+    it->next = getVarint(it->next, &toDifference);
+    it->length += (int)lengthDifference;
+    if (toDifference & 1)
+    {
+        it->to -= (int)((toDifference + 1) / 2);
+    }
+    else
+    {
+        it->to += (int)(toDifference / 2);
+    }
+    *road = (struct road){it->from, it->to, it->length};
+    return true;
+}
+
+/**
+ * Comparison function used by qsort that sorts roads by ascending `to`
+ */
+static int compareTo(const void *a, const void *b)
+{
+    const struct road *x = a;
+    const struct road *y = b;
+    return (x->to > y->to) - (x->to < y->to);
+}
+
+/**
+ * Orders roads by length, then by the city they go to
+ */
+static int compareLength(const void *a, const void *b)
+{
+    const struct road *x = a;
+    const struct road *y = b;
+    if (x->length != y->length)
+    {
+        return (x->length > y->length) - (x->length < y->length);
+    }
+    return compareTo(a, b);
+}
+
+/**
+ * Displays the map
  */
 void MapShow(Map m)
 {
     printf("Number of cities: %d\n", MapNumCities(m));
-    printf("Number of roads: %d\n", MapNumRoads(m));
+    printf("Number of roads: %ld\n", MapNumRoads(m));
 
     struct road *roads = malloc(MapNumRoads(m) * sizeof(struct road));
     if (roads == NULL)
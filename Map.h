@@ -1,13 +1,17 @@
 // Interface to the Map ADT
 // Cities are identified by integers between 0 and N - 1 where N is the
 // number of cities. All roads are bidirectional.
-// Cities can be given names via the MapSetName function.
-
-// !!! DO NOT MODIFY THIS FILE !!!
+// Cities can be given names via the MapSetName function, and can have an
+// informant via the MapSetInformant function.
 
 #ifndef MAP_H
 #define MAP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Allocator.h"
+
 struct road {
     int from;
     int to;
@@ -16,12 +20,37 @@ struct road {
 
 typedef struct map *Map;
 
+// Walks through a city's roads in the order of MapGetRoadsByLength,
+// decoding them one at a time. Its fields belong to the Map ADT.
+struct roadIterator {
+    const uint8_t *next;
+    const uint8_t *end;
+    int from;
+    int to;
+    int length;
+};
+
 /**
  * Creates a new map with the given number of cities and no roads
  * Assumes that `numCities` is positive
  */
 Map MapNew(int numCities);
 
+/**
+ * Like MapNew, but all of the map's memory comes from the given allocator,
+ * or from malloc if it is NULL
+ * NOTE: The allocator must outlive the map
+ */
+Map MapNewWithAllocator(int numCities, Allocator allocator);
+
+/**
+ * Returns a copy of the map, with its names, informants and roads, whose
+ * memory comes from the given allocator, or from malloc if it is NULL. The
+ * copy is independent of the original and has the same version.
+ * NOTE: The allocator must outlive the copy
+ */
+Map MapCopy(Map m, Allocator allocator);
+
 /**
  * Frees all memory allocated to the given map
  */
@@ -35,7 +64,12 @@ int MapNumCities(Map m);
 /**
  * Returns the number of roads on the given map
  */
-int MapNumRoads(Map m);
+long MapNumRoads(Map m);
+
+/**
+ * Returns the number of roads connected to the given city
+ */
+int MapNumRoadsFrom(Map m, int city);
 
 /**
  * Sets the name of the given city
@@ -49,6 +83,21 @@ void MapSetName(Map m, int city, char *name);
  */
 char *MapGetName(Map m, int city);
 
+/**
+ * Sets whether the given city has an informant
+ */
+void MapSetInformant(Map m, int city, bool hasInformant);
+
+/**
+ * Returns true if the given city has an informant
+ */
+bool MapHasInformant(Map m, int city);
+
+/**
+ * Returns the number of cities with an informant
+ */
+int MapNumInformants(Map m);
+
 /**
  * Inserts a road between two cities with the given length
  * Does nothing if there is already a road between the two cities
@@ -57,6 +106,49 @@ char *MapGetName(Map m, int city);
  */
 void MapInsertRoad(Map m, int city1, int city2, int length);
 
+/**
+ * Inserts the roads as if by calling MapInsertRoad on each of them in
+ * order, so a road between two cities that already have one is left out.
+ * On a map with no roads yet, every city's roads are sorted and encoded
+ * once rather than once per road, which is much faster for a whole map.
+ * The `from` field of each road is the first city.
+ */
+void MapInsertRoads(Map m, struct road roads[], long numRoads);
+
+/**
+ * Removes the road between two cities
+ * Does nothing if there is no road between the two cities
+ */
+void MapRemoveRoad(Map m, int city1, int city2);
+
+/**
+ * Changes the length of the road between two cities
+ * Does nothing if there is no road between the two cities
+ * Assumes that the length of the road is positive
+ */
+void MapSetRoadLength(Map m, int city1, int city2, int length);
+
+/**
+ * Returns the version of the map's roads, which changes whenever a road is
+ * inserted, removed or has its length changed. Anything computed from the
+ * roads can remember the version it was computed for to tell whether it is
+ * out of date.
+ */
+unsigned long MapVersion(Map m);
+
+/**
+ * Returns the version of the map's informants, which changes whenever an
+ * informant is added or removed. It is kept apart from MapVersion so that
+ * what is computed from the roads alone stays up to date.
+ */
+unsigned long MapInformantVersion(Map m);
+
+/**
+ * Returns a hash of the number of cities and every road on the map, which
+ * identifies the map's contents across runs. City names are not included.
+ */
+uint64_t MapHash(Map m);
+
 /**
  * Returns the length of the road between two cities, or 0 if no such
  * road exists
@@ -75,6 +167,31 @@ int MapContainsRoad(Map m, int city1, int city2);
  */
 int MapGetRoadsFrom(Map m, int city, struct road roads[]);
 
+/**
+ * Stores the roads connected to the given city whose length is at most
+ * `maxLength` (pass INT_MAX for all of them) in the given `roads` array,
+ * sorted by length with roads of the same length sorted by the `to` field,
+ * and returns the number of roads stored.
+ * Assumes that the roads array is at least as large as the number of roads
+ * connected to the city.
+ */
+int MapGetRoadsByLength(Map m, int city, int maxLength, struct road roads[]);
+
+/**
+ * Starts the iterator at the first of the roads connected to the given
+ * city, in the same order as MapGetRoadsByLength. The roads are decoded as
+ * the iterator goes, so this takes no memory and finding the roads no
+ * longer than some length stops at the first longer road.
+ * The iterator must not be used after the roads of the map change.
+ */
+void MapIterateRoads(Map m, int city, struct roadIterator *it);
+
+/**
+ * Stores the iterator's next road in `*road` and returns true, or returns
+ * false if there are no roads left
+ */
+bool MapNextRoad(struct roadIterator *it, struct road *road);
+
 /**
  * Displays the map
  */
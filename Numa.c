@@ -0,0 +1,131 @@
+// Implementation of the NUMA helpers
+// The nodes and their processors are read from sysfs, where each is a list
+// of ranges such as "0-3,8-11". Threads are pinned with sched_setaffinity,
+// and memory is placed with the mbind system call, called directly since
+// its wrapper belongs to libnuma. A node that cannot be reached through
+// these is treated as not being there.
+
+#define _GNU_SOURCE // for sched_setaffinity and the CPU_* macros
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Numa.h"
+
+#define NODE_DIRECTORY "/sys/devices/system/node"
+#define MAX_RANGES 256
+#define MAX_NODES 1024
+
+#define MPOL_PREFERRED 1 // from linux/mempolicy.h
+
+struct range
+{
+    int first;
+    int last;
+};
+
+static int readRanges(const char *path, struct range ranges[]);
+
+/**
+ * Returns one more than the highest online node
+ */
+int NumaNumNodes(void)
+{
+    struct range ranges[MAX_RANGES];
+    int numRanges = readRanges(NODE_DIRECTORY "/online", ranges);
+    int numNodes = 1;
+    for (int i = 0; i < numRanges; i++)
+    {
+        if (ranges[i].last + 1 > numNodes)
+        {
+            numNodes = ranges[i].last + 1;
+        }
+    }
+    return numNodes < MAX_NODES ? numNodes : MAX_NODES;
+}
+
+/**
+ * Sets the thread's affinity to the node's list of processors
+ */
+bool NumaPinThread(int node)
+{
+    char path[64];
+    snprintf(path, sizeof(path), NODE_DIRECTORY "/node%d/cpulist", node);
+    struct range ranges[MAX_RANGES];
+    int numRanges = readRanges(path, ranges);
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int i = 0; i < numRanges; i++)
+    {
+        for (int cpu = ranges[i].first;
+             cpu <= ranges[i].last && cpu < CPU_SETSIZE; cpu++)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    return CPU_COUNT(&cpus) > 0 &&
+           sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+/**
+ * Sets a preferred policy rather than a strict one, so that the memory
+ * still comes from another node if the given node runs out
+ */
+bool NumaBindMemory(void *p, size_t size, int node)
+{
+#ifdef SYS_mbind
+    if (node < 0 || node >= MAX_NODES)
+    {
+        return false;
+    }
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] =
+        1UL << (node % (8 * sizeof(unsigned long)));
+    // the kernel reads one bit fewer than it is told to
+    return syscall(SYS_mbind, p, size, MPOL_PREFERRED, mask, MAX_NODES + 1,
+                   0) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Reads a list of ranges from the file into `ranges` and returns the number
+ * of ranges, or 0 if the file cannot be read. A single number is a range
+ * of its own.
+ */
+static int readRanges(const char *path, struct range ranges[])
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+
+    int numRanges = 0;
+    int first;
+    while (numRanges < MAX_RANGES && fscanf(fp, "%d", &first) == 1)
+    {
+        int last = first;
+        int c = fgetc(fp);
+        if (c == '-')
+        {
+            if (fscanf(fp, "%d", &last) != 1)
+            {
+                break;
+            }
+            c = fgetc(fp);
+        }
+        ranges[numRanges++] = (struct range){first, last};
+        if (c != ',')
+        {
+            break;
+        }
+    }
+    fclose(fp);
+    return numRanges;
+}
@@ -0,0 +1,34 @@
+// Interface to the NUMA helpers
+// A machine with several sockets has a NUMA node for each of them: some
+// processors and the memory closest to them. Memory on another node takes
+// longer to reach, so threads that read a lot of memory run best pinned to
+// the node the memory is on. These helpers use Linux's own files and system
+// calls, so nothing else needs to be installed, and on a machine without
+// NUMA they behave as though it had a single node.
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Returns the number of NUMA nodes, which is 1 if the machine has no NUMA
+ * or it cannot be found out
+ */
+int NumaNumNodes(void);
+
+/**
+ * Restricts the calling thread to the processors of the given node.
+ * Returns false, leaving the thread as it was, if that cannot be done.
+ */
+bool NumaPinThread(int node);
+
+/**
+ * Asks for the pages of the given memory to be placed on the given node
+ * when they are first touched. Returns false if that cannot be done.
+ * NOTE: The memory must come from mmap and must not have been touched yet
+ */
+bool NumaBindMemory(void *p, size_t size, int node);
+
+#endif
@@ -0,0 +1,353 @@
+// Implementation of the Pool ADT using work stealing
+// Each worker has a double-ended queue of tasks. A worker takes tasks from
+// the back of its own queue (most recently submitted first, which keeps
+// related work on the same thread) and steals from the front of the other
+// queues when its own is empty. Tasks submitted from outside the pool are
+// spread over the queues in turn.
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Numa.h"
+#include "Pool.h"
+
+#define INITIAL_QUEUE_SIZE 64
+
+struct task
+{
+    PoolTask run;
+    void *arg;
+};
+
+struct taskQueue
+{
+    pthread_mutex_t lock;
+    struct task *tasks; // circular buffer
+    int size;
+    int front;
+    int numTasks;
+};
+
+struct worker
+{
+    Pool pool;
+    int id;
+    pthread_t thread;
+};
+
+struct pool
+{
+    int numThreads;
+    int node; // the NUMA node the workers are pinned to, or -1
+    struct worker *workers;
+    struct taskQueue *queues;
+    int nextQueue; // the queue the next outside task goes to
+
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;
+    pthread_cond_t allDone;
+    int numQueued;  // tasks waiting in a queue
+    int numPending; // tasks submitted but not yet finished
+    bool stopping;
+};
+
+// The worker that the current thread is, or NULL outside of every pool
+static __thread struct worker *currentWorker = NULL;
+
+static void printNullError(void);
+
+static void *workerLoop(void *arg);
+static bool takeTask(Pool p, int id, struct task *t);
+static void pushBack(struct taskQueue *q, struct task t);
+static bool popBack(struct taskQueue *q, struct task *t);
+static bool popFront(struct taskQueue *q, struct task *t);
+
+/**
+ * Creates a pool whose workers may run anywhere
+ */
+Pool PoolNew(int numThreads)
+{
+    return PoolNewOnNode(numThreads, -1);
+}
+
+/**
+ * Creates the queues and starts the worker threads
+ */
+Pool PoolNewOnNode(int numThreads, int node)
+{
+    assert(numThreads > 0);
+
+    Pool p = malloc(sizeof(struct pool));
+    if (p == NULL)
+    {
+        printNullError();
+    }
+    p->numThreads = numThreads;
+    p->node = node;
+    p->nextQueue = 0;
+    p->numQueued = 0;
+    p->numPending = 0;
+    p->stopping = false;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->workAvailable, NULL);
+    pthread_cond_init(&p->allDone, NULL);
+
+    p->queues = malloc(numThreads * sizeof(struct taskQueue));
+    p->workers = malloc(numThreads * sizeof(struct worker));
+    if (p->queues == NULL || p->workers == NULL)
+    {
+        printNullError();
+    }
+    for (int i = 0; i < numThreads; i++)
+    {
+        struct taskQueue *q = &p->queues[i];
+        pthread_mutex_init(&q->lock, NULL);
+        q->tasks = malloc(INITIAL_QUEUE_SIZE * sizeof(struct task));
+        if (q->tasks == NULL)
+        {
+            printNullError();
+        }
+        q->size = INITIAL_QUEUE_SIZE;
+        q->front = 0;
+        q->numTasks = 0;
+    }
+
+    for (int i = 0; i < numThreads; i++)
+    {
+        p->workers[i] = (struct worker){p, i, 0};
+        if (pthread_create(&p->workers[i].thread, NULL, workerLoop,
+                           &p->workers[i]) != 0)
+        {
+            fprintf(stderr, "error: couldn't start worker thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return p;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Waits for the tasks, tells the workers to stop and frees everything
+ */
+void PoolFree(Pool p)
+{
+    PoolWait(p);
+
+    pthread_mutex_lock(&p->lock);
+    p->stopping = true;
+    pthread_cond_broadcast(&p->workAvailable);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 0; i < p->numThreads; i++)
+    {
+        pthread_join(p->workers[i].thread, NULL);
+        pthread_mutex_destroy(&p->queues[i].lock);
+        free(p->queues[i].tasks);
+    }
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->workAvailable);
+    pthread_cond_destroy(&p->allDone);
+    free(p->queues);
+    free(p->workers);
+    free(p);
+}
+
+/**
+ * Returns the number of worker threads
+ */
+int PoolNumThreads(Pool p)
+{
+    return p->numThreads;
+}
+
+/**
+ * Puts the task on the current worker's own queue, or on the next queue in
+ * turn if the task comes from outside the pool
+ */
+void PoolSubmit(Pool p, PoolTask task, void *arg)
+{
+    int id;
+    pthread_mutex_lock(&p->lock);
+    p->numPending++;
+    if (currentWorker != NULL && currentWorker->pool == p)
+    {
+        id = currentWorker->id;
+    }
+    else
+    {
+        id = p->nextQueue;
+        p->nextQueue = (p->nextQueue + 1) % p->numThreads;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    pushBack(&p->queues[id], (struct task){task, arg});
+
+    pthread_mutex_lock(&p->lock);
+    p->numQueued++;
+    pthread_cond_signal(&p->workAvailable);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * Waits until there are no pending tasks
+ */
+void PoolWait(Pool p)
+{
+    pthread_mutex_lock(&p->lock);
+    while (p->numPending > 0)
+    {
+        pthread_cond_wait(&p->allDone, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * Returns the number of online processors, or 1 if it is unknown
+ */
+int PoolDefaultNumThreads(void)
+{
+    long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    return numProcessors > 0 ? (int)numProcessors : 1;
+}
+
+/**
+ * Runs tasks until the pool is stopped, sleeping whenever every queue is
+ * empty
+ */
+static void *workerLoop(void *arg)
+{
+    struct worker *w = arg;
+    Pool p = w->pool;
+    currentWorker = w;
+    if (p->node >= 0)
+    {
+        NumaPinThread(p->node);
+    }
+
+    while (true)
+    {
+        struct task t;
+        if (takeTask(p, w->id, &t))
+        {
+            t.run(t.arg);
+
+            pthread_mutex_lock(&p->lock);
+            p->numPending--;
+            if (p->numPending == 0)
+            {
+                pthread_cond_broadcast(&p->allDone);
+            }
+            pthread_mutex_unlock(&p->lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        while (p->numQueued <= 0 && !p->stopping)
+        {
+            pthread_cond_wait(&p->workAvailable, &p->lock);
+        }
+        bool stop = p->stopping && p->numQueued <= 0;
+        pthread_mutex_unlock(&p->lock);
+        if (stop)
+        {
+            break;
+        }
+    }
+
+    currentWorker = NULL;
+    return NULL;
+}
+
+/**
+ * Takes a task from the back of the worker's own queue, or failing that
+ * steals one from the front of another worker's queue
+ */
+static bool takeTask(Pool p, int id, struct task *t)
+{
+    bool found = popBack(&p->queues[id], t);
+    for (int i = 1; !found && i < p->numThreads; i++)
+    {
+        found = popFront(&p->queues[(id + i) % p->numThreads], t);
+    }
+
+    if (found)
+    {
+        pthread_mutex_lock(&p->lock);
+        p->numQueued--;
+        pthread_mutex_unlock(&p->lock);
+    }
+    return found;
+}
+
+/**
+ * Adds a task to the back of the queue, doubling the buffer if it is full
+ */
+static void pushBack(struct taskQueue *q, struct task t)
+{
+    pthread_mutex_lock(&q->lock);
+    if (q->numTasks == q->size)
+    {
+        struct task *new = malloc(2 * q->size * sizeof(struct task));
+        if (new == NULL)
+        {
+            printNullError();
+        }
+        for (int i = 0; i < q->numTasks; i++)
+        {
+            new[i] = q->tasks[(q->front + i) % q->size];
+        }
+        free(q->tasks);
+        q->tasks = new;
+        q->size *= 2;
+        q->front = 0;
+    }
+    q->tasks[(q->front + q->numTasks) % q->size] = t;
+    q->numTasks++;
+    pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * Removes the task at the back of the queue, returning false if it is empty
+ */
+static bool popBack(struct taskQueue *q, struct task *t)
+{
+    pthread_mutex_lock(&q->lock);
+    bool found = q->numTasks > 0;
+    if (found)
+    {
+        q->numTasks--;
+        *t = q->tasks[(q->front + q->numTasks) % q->size];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+/**
+ * Removes the task at the front of the queue, returning false if it is empty
+ */
+static bool popFront(struct taskQueue *q, struct task *t)
+{
+    pthread_mutex_lock(&q->lock);
+    bool found = q->numTasks > 0;
+    if (found)
+    {
+        *t = q->tasks[q->front];
+        q->front = (q->front + 1) % q->size;
+        q->numTasks--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
@@ -0,0 +1,58 @@
+// Interface to the Pool ADT
+// A pool is a fixed set of worker threads that run submitted tasks. Every
+// worker has its own queue of tasks, and a worker whose queue is empty
+// steals tasks from the other workers' queues, so uneven tasks still keep
+// every thread busy.
+
+#ifndef POOL_H
+#define POOL_H
+
+typedef struct pool *Pool;
+
+typedef void (*PoolTask)(void *arg);
+
+/**
+ * Creates a new pool with the given number of worker threads
+ * Assumes that `numThreads` is positive
+ */
+Pool PoolNew(int numThreads);
+
+/**
+ * Like PoolNew, but every worker thread is pinned to the given NUMA node
+ * (see Numa.h), so that tasks reading memory on that node, such as a map
+ * from Replicas.h, do not reach across to another node. A node of -1 is
+ * the same as PoolNew.
+ */
+Pool PoolNewOnNode(int numThreads, int node);
+
+/**
+ * Waits for all submitted tasks to finish, then stops the worker threads
+ * and frees all memory allocated to the pool
+ */
+void PoolFree(Pool p);
+
+/**
+ * Returns the number of worker threads in the pool
+ */
+int PoolNumThreads(Pool p);
+
+/**
+ * Submits a task which will call `task(arg)` on one of the worker threads
+ * Tasks may submit further tasks
+ */
+void PoolSubmit(Pool p, PoolTask task, void *arg);
+
+/**
+ * Waits until every submitted task has finished
+ * NOTE: Must not be called from inside a task
+ */
+void PoolWait(Pool p);
+
+/**
+ * Returns the number of threads to use when the user has not chosen: one
+ * per online processor
+ */
+int PoolDefaultNumThreads(void);
+
+#endif
+
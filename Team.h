@@ -0,0 +1,86 @@
+// Interface to the Team ADT
+// A team plans the moves of the detectives using the COORDINATED strategy
+// together. Every cycle it searches a few cycles ahead over the moves the
+// detectives could make between them and picks the joint move whose
+// cities are most likely to hold the thief. Until the thief has been seen
+// the team spreads out over the cities it has visited least, and after a
+// tip-off it closes in on the cities the thief could have reached since.
+//
+// The same positions of the detectives can be reached through many
+// different moves, so every position searched is stored in a fixed-size
+// transposition table under a Zobrist hash of each detective's city and
+// stamina, and is looked up there rather than searched again.
+
+#ifndef TEAM_H
+#define TEAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "Agent.h"
+#include "Allocator.h"
+#include "Map.h"
+
+#define TEAM_DEFAULT_DEPTH 2 // cycles searched ahead
+#define TEAM_DEFAULT_TABLE_BYTES (1024 * 1024)
+#define TEAM_DEFAULT_MAX_NODES 20000 // positions searched per cycle
+
+/**
+ * Creates a team with no members for the given map, with the default
+ * search settings. Its memory comes from the given allocator, or from
+ * malloc if it is NULL.
+ * NOTE: The map and the allocator must outlive the team
+ */
+Team TeamNew(Map m, Allocator allocator);
+
+/**
+ * Frees all memory allocated to the team. Its members are not freed.
+ */
+void TeamFree(Team t);
+
+/**
+ * Adds the agent to the team and gives it the team (see AgentSetTeam)
+ * NOTE: The agent must outlive the team
+ */
+void TeamAddMember(Team t, Agent agent);
+
+/**
+ * Sets how many cycles each plan looks ahead, how many bytes its
+ * transposition table may take (0 for no table) and how many positions
+ * it may search per cycle, which bounds the time a plan takes. When the
+ * positions run out, the rest of the search only looks at the first cycle.
+ * Planning does not depend on time, so a game plays out the same way every
+ * time with the same settings.
+ */
+void TeamSetSearch(Team t, int depth, size_t tableBytes, long maxNodes);
+
+/**
+ * Tells the team where the thief has just been seen
+ */
+void TeamSighting(Team t, int city);
+
+/**
+ * Plans the next move of every member from where it is now. Members who
+ * are following a least turns path after a tip-off are left out of the
+ * plan, since their moves are already decided.
+ */
+void TeamPlan(Team t);
+
+/**
+ * Returns the move planned for the agent by the last TeamPlan, or a rest
+ * if it was left out of the plan
+ */
+struct move TeamNextMove(Team t, Agent agent);
+
+/**
+ * Returns the number of positions searched by all the plans so far
+ */
+long TeamNumNodes(Team t);
+
+/**
+ * Returns the number of positions so far that were found in the
+ * transposition table instead of being searched
+ */
+long TeamNumTableHits(Team t);
+
+#endif
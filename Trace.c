@@ -0,0 +1,523 @@
+// Implementation of the Trace ADT
+// Records are formatted straight into a large buffer which is only handed
+// to stdio when it is nearly full.
+//
+// The binary format starts with the bytes "TRC1" followed by one record
+// after another. Every field of a record is stored as a variable length
+// integer (7 bits per byte, lowest bits first) and most fields are stored
+// as the difference from the previous record so that they fit in a byte:
+//  - the change in cycle since the previous record
+//  - the agent
+//  - `from` minus the agent's location after its previous record
+//  - `to` minus `from`
+//  - the stamina cost
+//  - the remaining stamina minus the agent's stamina after its previous
+//    record
+//  - the event
+// Signed differences are zig-zag encoded. Every agent is assumed to start
+// at city 0 with 0 stamina.
+//
+// The indexed format starts with the bytes "TRCI" and is split into blocks
+// of records, a new block starting with the first record of every cycle
+// that is a multiple of the keyframe interval. Each block starts with a
+// keyframe: the cycle of its first record, the number of agents seen so far
+// and every one of those agents' city and stamina (zig-zag encoded), which
+// is what the differences in the block start from. After that, the block's
+// records are encoded as in the binary format, so a block can be decoded
+// without looking at any block before it. After the last block comes the
+// index, one entry per block of its first cycle (4 bytes) and where it
+// starts in the file (8 bytes), then a footer of where the index starts
+// (8 bytes), the number of blocks (4 bytes), the keyframe interval (4
+// bytes) and the bytes "TRCX". Fixed size numbers are little-endian.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Trace.h"
+
+#define BUFFER_SIZE (1 << 20)
+#define MAX_RECORD_SIZE 256
+#define MAX_VARINT_SIZE 5
+
+struct agentState
+{
+    int location;
+    int stamina;
+};
+
+struct trace
+{
+    FILE *fp;
+    int format;
+    char *buffer;
+    int bufferUsed;
+
+    // state needed for the delta encoding of the binary format
+    int lastCycle;
+    struct agentState *agents;
+    int numAgents;
+    int numAgentsSeen; // one more than the highest agent in any record
+
+    // for the indexed format: where every block starts
+    uint64_t bytesWritten; // to the file so far
+    int keyframeInterval;
+    struct keyframe *keyframes;
+    int numKeyframes;
+    int keyframesSize;
+};
+
+// A block of an indexed trace
+struct keyframe
+{
+    int cycle;
+    uint64_t offset;
+};
+
+static void printNullError(void);
+static void printWriteError(void);
+
+static void writeCsv(Trace t, struct traceRecord rec);
+static void writeJsonl(Trace t, struct traceRecord rec);
+static void writeBinary(Trace t, struct traceRecord rec);
+static void writeIndexed(Trace t, struct traceRecord rec);
+static void writeKeyframe(Trace t, int cycle);
+static void writeIndex(Trace t);
+static struct agentState *getAgentState(Trace t, int agent);
+static void emptyBuffer(Trace t);
+static void makeRoom(Trace t, int numBytes);
+
+static void appendString(Trace t, char *s);
+static void appendInt(Trace t, int n);
+static void appendVarint(Trace t, unsigned int n);
+static void appendFixed(Trace t, uint64_t n, int numBytes);
+static unsigned int zigzag(int n);
+
+static char *eventNames[] = {
+    "move", "rest", "tip-off", "caught", "escaped", "cold",
+};
+
+/**
+ * Creates a new trace and writes the header of the chosen format
+ */
+Trace TraceNew(FILE *fp, int format)
+{
+    assert(format == TRACE_CSV || format == TRACE_JSONL ||
+           format == TRACE_BINARY || format == TRACE_INDEXED);
+
+    Trace t = malloc(sizeof(struct trace));
+    if (t == NULL)
+    {
+        printNullError();
+    }
+    t->fp = fp;
+    t->format = format;
+    t->buffer = malloc(BUFFER_SIZE);
+    if (t->buffer == NULL)
+    {
+        printNullError();
+    }
+    t->bufferUsed = 0;
+    t->lastCycle = 0;
+    t->agents = NULL;
+    t->numAgents = 0;
+    t->numAgentsSeen = 0;
+    t->bytesWritten = 0;
+    t->keyframeInterval = TRACE_DEFAULT_KEYFRAME_INTERVAL;
+    t->keyframes = NULL;
+    t->numKeyframes = 0;
+    t->keyframesSize = 0;
+
+    if (format == TRACE_CSV)
+    {
+        appendString(t, "cycle,agent,from,to,staminaCost,stamina,event\n");
+    }
+    else if (format == TRACE_BINARY)
+    {
+        appendString(t, "TRC1");
+    }
+    else if (format == TRACE_INDEXED)
+    {
+        appendString(t, "TRCI");
+    }
+    return t;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Prints an error message if the trace cannot be written and exits the
+ * program
+ */
+static void printWriteError(void)
+{
+    fprintf(stderr, "error: failed to write trace\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Writes the index of an indexed trace, flushes the trace and frees the
+ * buffer, the agent states, the index and the trace
+ */
+void TraceFree(Trace t)
+{
+    if (t->format == TRACE_INDEXED)
+    {
+        writeIndex(t);
+    }
+    TraceFlush(t);
+    free(t->buffer);
+    free(t->agents);
+    free(t->keyframes);
+    free(t);
+}
+
+/**
+ * Returns the format with the given name, or -1 if the name is unknown
+ */
+int TraceFormatFromName(char *name)
+{
+    if (strcmp(name, "csv") == 0)
+    {
+        return TRACE_CSV;
+    }
+    else if (strcmp(name, "jsonl") == 0)
+    {
+        return TRACE_JSONL;
+    }
+    else if (strcmp(name, "binary") == 0)
+    {
+        return TRACE_BINARY;
+    }
+    else if (strcmp(name, "indexed") == 0)
+    {
+        return TRACE_INDEXED;
+    }
+    return -1;
+}
+
+/**
+ * Sets the keyframe interval
+ */
+void TraceSetKeyframeInterval(Trace t, int cycles)
+{
+    assert(cycles > 0 && t->numKeyframes == 0);
+    t->keyframeInterval = cycles;
+}
+
+/**
+ * Formats the record into the buffer, first flushing the buffer if the
+ * record might not fit
+ */
+void TraceWrite(Trace t, struct traceRecord rec)
+{
+    assert(rec.event >= TRACE_MOVE && rec.event <= TRACE_COLD);
+
+    if (t->bufferUsed > BUFFER_SIZE - MAX_RECORD_SIZE)
+    {
+        TraceFlush(t);
+    }
+
+    if (t->format == TRACE_CSV)
+    {
+        writeCsv(t, rec);
+    }
+    else if (t->format == TRACE_JSONL)
+    {
+        writeJsonl(t, rec);
+    }
+    else if (t->format == TRACE_BINARY)
+    {
+        writeBinary(t, rec);
+    }
+    else
+    {
+        writeIndexed(t, rec);
+    }
+}
+
+/**
+ * Writes the buffered records to the file and empties the buffer
+ */
+void TraceFlush(Trace t)
+{
+    emptyBuffer(t);
+    if (fflush(t->fp) != 0)
+    {
+        printWriteError();
+    }
+}
+
+/**
+ * Formats the record as a line of comma separated values
+ */
+static void writeCsv(Trace t, struct traceRecord rec)
+{
+    appendInt(t, rec.cycle);
+    appendString(t, ",");
+    appendInt(t, rec.agent);
+    appendString(t, ",");
+    appendInt(t, rec.from);
+    appendString(t, ",");
+    appendInt(t, rec.to);
+    appendString(t, ",");
+    appendInt(t, rec.staminaCost);
+    appendString(t, ",");
+    appendInt(t, rec.stamina);
+    appendString(t, ",");
+    appendString(t, eventNames[rec.event]);
+    appendString(t, "\n");
+}
+
+/**
+ * Formats the record as a single line JSON object
+ */
+static void writeJsonl(Trace t, struct traceRecord rec)
+{
+    appendString(t, "{\"cycle\":");
+    appendInt(t, rec.cycle);
+    appendString(t, ",\"agent\":");
+    appendInt(t, rec.agent);
+    appendString(t, ",\"from\":");
+    appendInt(t, rec.from);
+    appendString(t, ",\"to\":");
+    appendInt(t, rec.to);
+    appendString(t, ",\"staminaCost\":");
+    appendInt(t, rec.staminaCost);
+    appendString(t, ",\"stamina\":");
+    appendInt(t, rec.stamina);
+    appendString(t, ",\"event\":\"");
+    appendString(t, eventNames[rec.event]);
+    appendString(t, "\"}\n");
+}
+
+/**
+ * Encodes the record as differences from the previous records, as described
+ * at the top of this file
+ */
+static void writeBinary(Trace t, struct traceRecord rec)
+{
+    struct agentState *prev = getAgentState(t, rec.agent);
+
+    appendVarint(t, zigzag(rec.cycle - t->lastCycle));
+    appendVarint(t, rec.agent);
+    appendVarint(t, zigzag(rec.from - prev->location));
+    appendVarint(t, zigzag(rec.to - rec.from));
+    appendVarint(t, rec.staminaCost);
+    appendVarint(t, zigzag(rec.stamina - prev->stamina));
+    appendVarint(t, rec.event);
+
+    t->lastCycle = rec.cycle;
+    prev->location = rec.to;
+    prev->stamina = rec.stamina;
+}
+
+/**
+ * Starts a new block with a keyframe if the record is the first of a
+ * multiple of the keyframe interval, then encodes the record as in the
+ * binary format
+ */
+static void writeIndexed(Trace t, struct traceRecord rec)
+{
+    if (t->numKeyframes == 0 ||
+        rec.cycle / t->keyframeInterval !=
+            t->keyframes[t->numKeyframes - 1].cycle / t->keyframeInterval)
+    {
+        writeKeyframe(t, rec.cycle);
+    }
+    writeBinary(t, rec);
+}
+
+/**
+ * Adds a block starting at the given cycle to the index and writes its
+ * keyframe
+ */
+static void writeKeyframe(Trace t, int cycle)
+{
+    if (t->numKeyframes == t->keyframesSize)
+    {
+        t->keyframesSize = t->keyframesSize == 0 ? 64 : 2 * t->keyframesSize;
+        t->keyframes = realloc(t->keyframes,
+                               t->keyframesSize * sizeof(struct keyframe));
+        if (t->keyframes == NULL)
+        {
+            printNullError();
+        }
+    }
+    t->keyframes[t->numKeyframes++] =
+        (struct keyframe){cycle, t->bytesWritten + t->bufferUsed};
+
+    makeRoom(t, 2 * MAX_VARINT_SIZE);
+    appendVarint(t, zigzag(cycle));
+    appendVarint(t, t->numAgentsSeen);
+    for (int i = 0; i < t->numAgentsSeen; i++)
+    {
+        makeRoom(t, 2 * MAX_VARINT_SIZE);
+        appendVarint(t, zigzag(t->agents[i].location));
+        appendVarint(t, zigzag(t->agents[i].stamina));
+    }
+    t->lastCycle = cycle;
+}
+
+/**
+ * Writes the index of the blocks and the footer, as described at the top
+ * of this file
+ */
+static void writeIndex(Trace t)
+{
+    uint64_t indexOffset = t->bytesWritten + t->bufferUsed;
+    for (int i = 0; i < t->numKeyframes; i++)
+    {
+        makeRoom(t, 12);
+        appendFixed(t, (uint32_t)t->keyframes[i].cycle, 4);
+        appendFixed(t, t->keyframes[i].offset, 8);
+    }
+    makeRoom(t, 20);
+    appendFixed(t, indexOffset, 8);
+    appendFixed(t, t->numKeyframes, 4);
+    appendFixed(t, t->keyframeInterval, 4);
+    appendString(t, "TRCX");
+}
+
+/**
+ * Returns the last known state of the given agent, growing the array of
+ * agent states if this is the first record for the agent
+ */
+static struct agentState *getAgentState(Trace t, int agent)
+{
+    assert(agent >= 0);
+
+    if (agent >= t->numAgents)
+    {
+        int newNumAgents = t->numAgents == 0 ? 8 : t->numAgents;
+        while (newNumAgents <= agent)
+        {
+            newNumAgents *= 2;
+        }
+        struct agentState *new = realloc(t->agents, newNumAgents *
+                                                    sizeof(struct agentState));
+        if (new == NULL)
+        {
+            printNullError();
+        }
+        for (int i = t->numAgents; i < newNumAgents; i++)
+        {
+            new[i] = (struct agentState){0, 0};
+        }
+        t->agents = new;
+        t->numAgents = newNumAgents;
+    }
+    if (agent >= t->numAgentsSeen)
+    {
+        t->numAgentsSeen = agent + 1;
+    }
+    return &t->agents[agent];
+}
+
+/**
+ * Writes the buffered bytes to the file and empties the buffer
+ */
+static void emptyBuffer(Trace t)
+{
+    if (t->bufferUsed > 0)
+    {
+        if (fwrite(t->buffer, 1, t->bufferUsed, t->fp) != (size_t)t->bufferUsed)
+        {
+            printWriteError();
+        }
+        t->bytesWritten += t->bufferUsed;
+        t->bufferUsed = 0;
+    }
+}
+
+/**
+ * Empties the buffer if the given number of bytes would not fit in it
+ */
+static void makeRoom(Trace t, int numBytes)
+{
+    if (t->bufferUsed + numBytes > BUFFER_SIZE)
+    {
+        emptyBuffer(t);
+    }
+}
+
+/**
+ * Copies the string into the buffer
+ */
+static void appendString(Trace t, char *s)
+{
+    int len = strlen(s);
+    memcpy(t->buffer + t->bufferUsed, s, len);
+    t->bufferUsed += len;
+}
+
+/**
+ * Writes the decimal digits of the number into the buffer
+ */
+static void appendInt(Trace t, int n)
+{
+    char digits[12];
+    int numDigits = 0;
+    unsigned int value = n;
+
+    if (n < 0)
+    {
+        t->buffer[t->bufferUsed++] = '-';
+        value = -(unsigned int)n;
+    }
+    do
+    {
+        digits[numDigits++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    while (numDigits > 0)
+    {
+        t->buffer[t->bufferUsed++] = digits[--numDigits];
+    }
+}
+
+/**
+ * Writes the number into the buffer 7 bits at a time, setting the top bit
+ * of every byte except the last
+ */
+static void appendVarint(Trace t, unsigned int n)
+{
+    while (n >= 0x80)
+    {
+        t->buffer[t->bufferUsed++] = (char)(n | 0x80);
+        n >>= 7;
+    }
+    t->buffer[t->bufferUsed++] = (char)n;
+}
+
+/**
+ * Writes the lowest `numBytes` bytes of the number into the buffer, lowest
+ * byte first
+ */
+static void appendFixed(Trace t, uint64_t n, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++)
+    {
+        t->buffer[t->bufferUsed++] = (char)(n >> (8 * i));
+    }
+}
+
+/**
+ * Maps signed numbers to unsigned numbers so that numbers close to zero
+ * stay small: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+ */
+static unsigned int zigzag(int n)
+{
+    return ((unsigned int)n << 1) ^ (unsigned int)(n >> 31);
+}
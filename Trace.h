@@ -0,0 +1,79 @@
+// Interface to the Trace ADT
+// A trace records what every agent did in every cycle of a game. Records
+// are collected in a large in-memory buffer and written out in bulk, so
+// long runs can be captured without printing a line per agent per cycle.
+// The indexed format can be read back from any cycle with TraceReader.h.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+// Constants to represent the output formats of a trace
+#define TRACE_CSV       0
+#define TRACE_JSONL     1
+#define TRACE_BINARY    2
+#define TRACE_INDEXED   3
+
+#define TRACE_DEFAULT_KEYFRAME_INTERVAL 1024 // cycles between keyframes
+
+// Constants to represent what happened in a record
+#define TRACE_MOVE      0 // the agent moved along a road
+#define TRACE_REST      1 // the agent stayed and recovered its stamina
+#define TRACE_TIP_OFF   2 // the agent was told where the thief is
+#define TRACE_CAUGHT    3 // the thief was caught
+#define TRACE_ESCAPED   4 // the thief reached the getaway city
+#define TRACE_COLD      5 // the time ran out
+
+typedef struct trace *Trace;
+
+struct traceRecord {
+    int cycle;
+    int agent;
+    int from;
+    int to;
+    int staminaCost;
+    int stamina; // stamina remaining after the record
+    int event;
+};
+
+/**
+ * Creates a new trace which writes to the given file in the given format
+ * NOTE: The file is owned by the caller and is not closed by TraceFree
+ */
+Trace TraceNew(FILE *fp, int format);
+
+/**
+ * Flushes any buffered records and frees all memory allocated to the trace.
+ * An indexed trace's index is written here, and the trace cannot be read
+ * back until it has been.
+ */
+void TraceFree(Trace t);
+
+/**
+ * Returns the format constant with the given name ("csv", "jsonl",
+ * "binary" or "indexed"), or -1 if there is no such format
+ */
+int TraceFormatFromName(char *name);
+
+/**
+ * Sets the number of cycles between the keyframes of an indexed trace,
+ * which every agent's city and stamina are saved in. Reading back from a
+ * cycle decodes at most this many cycles of records before it. Must be
+ * called before the first record is written.
+ */
+void TraceSetKeyframeInterval(Trace t, int cycles);
+
+/**
+ * Adds a record to the trace. Records in an indexed trace must be written
+ * in order of cycle.
+ */
+void TraceWrite(Trace t, struct traceRecord rec);
+
+/**
+ * Writes all buffered records to the trace's file
+ */
+void TraceFlush(Trace t);
+
+#endif
+
@@ -0,0 +1,511 @@
+// Implementation of the TraceReader ADT
+// The whole file is mapped into memory and checked against its footer and
+// index (see Trace.c for the format). Seeking finds the last block whose
+// keyframe is at or before the cycle with a binary search over the index,
+// loads the keyframe into the cursor's agent states and decodes records
+// until it reaches one from the cycle. A cursor moves from the end of one
+// block into the next by loading the next keyframe, which holds the states
+// the cursor already has.
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Trace.h"
+#include "TraceReader.h"
+
+#define MAGIC_SIZE 4
+#define INDEX_ENTRY_SIZE 12
+#define FOOTER_SIZE 20
+
+// A block of the trace
+struct block
+{
+    int cycle; // of its first record
+    uint64_t offset;
+};
+
+struct traceReader
+{
+    const uint8_t *data;
+    size_t size;
+    struct block *blocks;
+    int numBlocks;
+    uint64_t indexOffset; // where the last block ends
+    int lastCycle;
+};
+
+struct agentState
+{
+    int location;
+    int stamina;
+};
+
+struct traceCursor
+{
+    TraceReader r;
+    int block;
+    const uint8_t *next;
+    const uint8_t *end; // of the block
+
+    int lastCycle;
+    struct agentState *agents;
+    int numAgents;
+    int agentsSize;
+};
+
+static void printNullError(void);
+
+static bool readIndex(TraceReader r);
+static TraceCursor newCursor(TraceReader r);
+static bool startBlock(TraceCursor c, int block);
+static bool peekRecord(TraceCursor c, struct traceRecord *rec,
+                       const uint8_t **after);
+static void applyRecord(TraceCursor c, struct traceRecord rec,
+                        const uint8_t *after);
+static struct agentState *getAgentState(TraceCursor c, int agent);
+static bool readVarint(const uint8_t **p, const uint8_t *end,
+                       unsigned int *value);
+static uint64_t readFixed(const uint8_t *p, int numBytes);
+static int unzigzag(unsigned int n);
+
+/**
+ * Maps the file and checks its magic bytes, footer and index, then finds
+ * the last cycle by decoding the last block
+ */
+TraceReader TraceReaderOpen(char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        (size_t)st.st_size < MAGIC_SIZE + FOOTER_SIZE)
+    {
+        close(fd);
+        return NULL;
+    }
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    TraceReader r = malloc(sizeof(struct traceReader));
+    if (r == NULL)
+    {
+        printNullError();
+    }
+    r->data = mapping;
+    r->size = st.st_size;
+    r->blocks = NULL;
+    r->numBlocks = 0;
+    r->lastCycle = -1;
+    if (!readIndex(r))
+    {
+        TraceReaderFree(r);
+        return NULL;
+    }
+
+    if (r->numBlocks > 0)
+    {
+        TraceCursor c = newCursor(r);
+        struct traceRecord rec;
+        bool ok = startBlock(c, r->numBlocks - 1);
+        while (ok && c->next < c->end)
+        {
+            const uint8_t *after;
+            ok = peekRecord(c, &rec, &after);
+            if (ok)
+            {
+                applyRecord(c, rec, after);
+                r->lastCycle = rec.cycle;
+            }
+        }
+        TraceCursorFree(c);
+        if (!ok)
+        {
+            TraceReaderFree(r);
+            return NULL;
+        }
+    }
+    return r;
+}
+
+/**
+ * Unmaps the file and frees the index and the reader
+ */
+void TraceReaderFree(TraceReader r)
+{
+    munmap((void *)r->data, r->size);
+    free(r->blocks);
+    free(r);
+}
+
+/**
+ * Returns the cycle of the first block's first record
+ */
+int TraceReaderFirstCycle(TraceReader r)
+{
+    return r->numBlocks == 0 ? -1 : r->blocks[0].cycle;
+}
+
+/**
+ * Returns the cycle of the last record, found when the trace was opened
+ */
+int TraceReaderLastCycle(TraceReader r)
+{
+    return r->lastCycle;
+}
+
+/**
+ * Starts a cursor at the last keyframe at or before the cycle and decodes
+ * the records before the cycle
+ */
+TraceCursor TraceSeek(TraceReader r, int cycle)
+{
+    TraceCursor c = newCursor(r);
+    if (r->numBlocks == 0)
+    {
+        return c;
+    }
+
+    int low = 0;
+    int high = r->numBlocks - 1;
+    while (low < high)
+    {
+        int mid = low + (high - low + 1) / 2;
+        if (r->blocks[mid].cycle <= cycle)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    // every later block starts after the cycle, so the records before it
+    // all come before the end of this block
+    bool ok = startBlock(c, low);
+    while (ok && c->next < c->end)
+    {
+        struct traceRecord rec;
+        const uint8_t *after;
+        ok = peekRecord(c, &rec, &after) && rec.cycle < cycle;
+        if (ok)
+        {
+            applyRecord(c, rec, after);
+        }
+    }
+    return c;
+}
+
+/**
+ * Frees the agent states and the cursor
+ */
+void TraceCursorFree(TraceCursor c)
+{
+    free(c->agents);
+    free(c);
+}
+
+/**
+ * Moves on to the next block if the cursor is at the end of one, then
+ * decodes the next record
+ */
+bool TraceNext(TraceCursor c, struct traceRecord *rec)
+{
+    while (c->next == c->end)
+    {
+        if (c->block + 1 >= c->r->numBlocks || !startBlock(c, c->block + 1))
+        {
+            return false;
+        }
+    }
+
+    const uint8_t *after;
+    if (!peekRecord(c, rec, &after))
+    {
+        // a malformed record ends the trace
+        c->next = c->end;
+        c->block = c->r->numBlocks;
+        return false;
+    }
+    applyRecord(c, *rec, after);
+    return true;
+}
+
+/**
+ * Returns the number of agents in the cursor's states
+ */
+int TraceCursorNumAgents(TraceCursor c)
+{
+    return c->numAgents;
+}
+
+/**
+ * Returns the agent's city from the cursor's states
+ */
+int TraceCursorLocation(TraceCursor c, int agent)
+{
+    assert(agent >= 0);
+    return agent < c->numAgents ? c->agents[agent].location : 0;
+}
+
+/**
+ * Returns the agent's stamina from the cursor's states
+ */
+int TraceCursorStamina(TraceCursor c, int agent)
+{
+    assert(agent >= 0);
+    return agent < c->numAgents ? c->agents[agent].stamina : 0;
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Checks the magic bytes and the footer and reads the index, returning
+ * false if the file is not a complete indexed trace
+ */
+static bool readIndex(TraceReader r)
+{
+    const uint8_t *footer = r->data + r->size - FOOTER_SIZE;
+    if (memcmp(r->data, "TRCI", MAGIC_SIZE) != 0 ||
+        memcmp(footer + 16, "TRCX", MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+    r->indexOffset = readFixed(footer, 8);
+    uint64_t numBlocks = readFixed(footer + 8, 4);
+    if (r->indexOffset < MAGIC_SIZE ||
+        r->indexOffset + numBlocks * INDEX_ENTRY_SIZE + FOOTER_SIZE !=
+            r->size)
+    {
+        return false;
+    }
+
+    r->numBlocks = numBlocks;
+    r->blocks = malloc((numBlocks > 0 ? numBlocks : 1) *
+                       sizeof(struct block));
+    if (r->blocks == NULL)
+    {
+        printNullError();
+    }
+    uint64_t lastOffset = MAGIC_SIZE;
+    for (int i = 0; i < r->numBlocks; i++)
+    {
+        const uint8_t *entry = r->data + r->indexOffset + i * INDEX_ENTRY_SIZE;
+        r->blocks[i].cycle = (int)(uint32_t)readFixed(entry, 4);
+        r->blocks[i].offset = readFixed(entry + 4, 8);
+        if (r->blocks[i].offset < lastOffset ||
+            r->blocks[i].offset > r->indexOffset ||
+            (i > 0 && r->blocks[i].cycle <= r->blocks[i - 1].cycle))
+        {
+            return false;
+        }
+        lastOffset = r->blocks[i].offset;
+    }
+    return true;
+}
+
+/**
+ * Creates a cursor with no agents at the end of no block
+ */
+static TraceCursor newCursor(TraceReader r)
+{
+    TraceCursor c = malloc(sizeof(struct traceCursor));
+    if (c == NULL)
+    {
+        printNullError();
+    }
+    c->r = r;
+    c->block = r->numBlocks;
+    c->next = NULL;
+    c->end = NULL;
+    c->lastCycle = 0;
+    c->agents = NULL;
+    c->numAgents = 0;
+    c->agentsSize = 0;
+    return c;
+}
+
+/**
+ * Moves the cursor to the start of the block and loads its keyframe,
+ * returning false if the keyframe is malformed
+ */
+static bool startBlock(TraceCursor c, int block)
+{
+    TraceReader r = c->r;
+    c->block = block;
+    c->next = r->data + r->blocks[block].offset;
+    c->end = r->data + (block + 1 < r->numBlocks ? r->blocks[block + 1].offset
+                                                 : r->indexOffset);
+
+    unsigned int cycle;
+    unsigned int numAgents;
+    if (!readVarint(&c->next, c->end, &cycle) ||
+        !readVarint(&c->next, c->end, &numAgents))
+    {
+        c->next = c->end;
+        return false;
+    }
+    c->lastCycle = unzigzag(cycle);
+    for (unsigned int i = 0; i < numAgents; i++)
+    {
+        unsigned int location;
+        unsigned int stamina;
+        if (!readVarint(&c->next, c->end, &location) ||
+            !readVarint(&c->next, c->end, &stamina))
+        {
+            c->next = c->end;
+            return false;
+        }
+        *getAgentState(c, i) = (struct agentState){unzigzag(location),
+                                                   unzigzag(stamina)};
+    }
+    return true;
+}
+
+/**
+ * Decodes the record at the cursor without moving past it, storing where
+ * it ends in `*after`. Returns false if the record is malformed.
+ */
+static bool peekRecord(TraceCursor c, struct traceRecord *rec,
+                       const uint8_t **after)
+{
+    const uint8_t *p = c->next;
+    unsigned int fields[7];
+    for (int i = 0; i < 7; i++)
+    {
+        if (!readVarint(&p, c->end, &fields[i]))
+        {
+            return false;
+        }
+    }
+    if (fields[1] > INT32_MAX)
+    {
+        return false;
+    }
+
+    int agent = fields[1];
+    struct agentState prev = {0, 0};
+    if (agent < c->numAgents)
+    {
+        prev = c->agents[agent];
+    }
+    rec->cycle = c->lastCycle + unzigzag(fields[0]);
+    rec->agent = agent;
+    rec->from = prev.location + unzigzag(fields[2]);
+    rec->to = rec->from + unzigzag(fields[3]);
+    rec->staminaCost = (int)fields[4];
+    rec->stamina = prev.stamina + unzigzag(fields[5]);
+    rec->event = fields[6];
+    *after = p;
+    return rec->event >= TRACE_MOVE && rec->event <= TRACE_COLD;
+}
+
+/**
+ * Applies a record decoded by peekRecord to the agents' states and moves
+ * the cursor past it
+ */
+static void applyRecord(TraceCursor c, struct traceRecord rec,
+                        const uint8_t *after)
+{
+    struct agentState *state = getAgentState(c, rec.agent);
+    state->location = rec.to;
+    state->stamina = rec.stamina;
+    c->lastCycle = rec.cycle;
+    c->next = after;
+}
+
+/**
+ * Returns the cursor's state for the agent, growing the array of states if
+ * the agent has not been seen before
+ */
+static struct agentState *getAgentState(TraceCursor c, int agent)
+{
+    if (agent >= c->agentsSize)
+    {
+        int newSize = c->agentsSize == 0 ? 8 : c->agentsSize;
+        while (newSize <= agent)
+        {
+            newSize *= 2;
+        }
+        c->agents = realloc(c->agents, newSize * sizeof(struct agentState));
+        if (c->agents == NULL)
+        {
+            printNullError();
+        }
+        c->agentsSize = newSize;
+    }
+    while (c->numAgents <= agent)
+    {
+        c->agents[c->numAgents++] = (struct agentState){0, 0};
+    }
+    return &c->agents[agent];
+}
+
+/**
+ * Reads a number written 7 bits at a time, lowest bits first, returning
+ * false if it runs past the end or does not fit in 32 bits
+ */
+static bool readVarint(const uint8_t **p, const uint8_t *end,
+                       unsigned int *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (*p == end)
+        {
+            return false;
+        }
+        uint8_t byte = *(*p)++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return result <= UINT32_MAX;
+        }
+    }
+    return false;
+}
+
+/**
+ * Reads a little-endian number of the given number of bytes
+ */
+static uint64_t readFixed(const uint8_t *p, int numBytes)
+{
+    uint64_t n = 0;
+    for (int i = 0; i < numBytes; i++)
+    {
+        n |= (uint64_t)p[i] << (8 * i);
+    }
+    return n;
+}
+
+/**
+ * Undoes the zig-zag encoding of Trace.c: 0, 1, 2, 3, 4, ... become
+ * 0, -1, 1, -2, 2, ...
+ */
+static int unzigzag(unsigned int n)
+{
+    return (int)(n >> 1) ^ -(int)(n & 1);
+}
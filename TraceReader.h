@@ -0,0 +1,83 @@
+// Interface to the TraceReader ADT
+// Reads back a trace written in the indexed format (see Trace.h) from any
+// cycle. The trace's index gives the keyframe at or before the cycle, which
+// holds every agent's city and stamina, so seeking to a cycle only decodes
+// the records since that keyframe rather than the whole trace. A cursor
+// then replays the records forward from there.
+//
+// Cursors only read the trace, so several cursors on the same reader can be
+// used on different threads at once, for example to scan a long trace by
+// ranges of cycles in parallel.
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <stdbool.h>
+
+#include "Trace.h"
+
+typedef struct traceReader *TraceReader;
+typedef struct traceCursor *TraceCursor;
+
+/**
+ * Maps the indexed trace in the given file into memory and reads its
+ * index. Returns NULL if the file could not be opened or is not a complete
+ * indexed trace.
+ */
+TraceReader TraceReaderOpen(char *filename);
+
+/**
+ * Unmaps the trace and frees all memory allocated to the reader
+ * NOTE: Every cursor on the reader must be freed first
+ */
+void TraceReaderFree(TraceReader r);
+
+/**
+ * Returns the cycle of the first record in the trace, or -1 if there are
+ * no records
+ */
+int TraceReaderFirstCycle(TraceReader r);
+
+/**
+ * Returns the cycle of the last record in the trace, or -1 if there are no
+ * records
+ */
+int TraceReaderLastCycle(TraceReader r);
+
+/**
+ * Returns a cursor at the first record whose cycle is at least the given
+ * cycle, with every agent's city and stamina as they were just before it.
+ * Decodes at most one keyframe interval of records.
+ */
+TraceCursor TraceSeek(TraceReader r, int cycle);
+
+/**
+ * Frees all memory allocated to the cursor
+ */
+void TraceCursorFree(TraceCursor c);
+
+/**
+ * Stores the cursor's next record in `*rec`, applies it to the agents'
+ * states and moves past it. Returns false if there are no records left.
+ */
+bool TraceNext(TraceCursor c, struct traceRecord *rec);
+
+/**
+ * Returns the number of agents the cursor has seen a record for so far,
+ * including in keyframes
+ */
+int TraceCursorNumAgents(TraceCursor c);
+
+/**
+ * Returns the city the agent was in after the last record the cursor has
+ * gone past, or 0 if it has seen no record for the agent
+ */
+int TraceCursorLocation(TraceCursor c, int agent);
+
+/**
+ * Returns the agent's stamina after the last record the cursor has gone
+ * past, or 0 if it has seen no record for the agent
+ */
+int TraceCursorStamina(TraceCursor c, int agent);
+
+#endif
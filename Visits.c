@@ -0,0 +1,82 @@
+// Implementation of the Visits ADT
+// The counts are an array of atomic integers. Counting a visit only has to
+// be atomic with respect to other visits, not ordered with anything else,
+// since the moves that read the counts are worked out before any of them
+// are made.
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Allocator.h"
+#include "Visits.h"
+
+struct visits
+{
+    Allocator allocator;
+    int numCities;
+    _Atomic int *counts;
+};
+
+static void printNullError(void);
+
+/**
+ * Creates the counts with every city at zero
+ */
+Visits VisitsNew(int numCities, Allocator allocator)
+{
+    Visits v = AllocatorMalloc(allocator, sizeof(struct visits));
+    if (v == NULL)
+    {
+        printNullError();
+    }
+    v->allocator = allocator;
+    v->numCities = numCities;
+    v->counts = AllocatorMalloc(allocator, numCities * sizeof(_Atomic int));
+    if (v->counts == NULL)
+    {
+        printNullError();
+    }
+    for (int i = 0; i < numCities; i++)
+    {
+        atomic_init(&v->counts[i], 0);
+    }
+    return v;
+}
+
+/**
+ * Frees the counts
+ */
+void VisitsFree(Visits v)
+{
+    AllocatorRelease(v->allocator, v->counts);
+    AllocatorRelease(v->allocator, v);
+}
+
+/**
+ * Adds one to the city's count
+ */
+void VisitsAdd(Visits v, int city)
+{
+    assert(city >= 0 && city < v->numCities);
+    atomic_fetch_add_explicit(&v->counts[city], 1, memory_order_relaxed);
+}
+
+/**
+ * Returns the city's count
+ */
+int VisitsCount(Visits v, int city)
+{
+    assert(city >= 0 && city < v->numCities);
+    return atomic_load_explicit(&v->counts[city], memory_order_relaxed);
+}
+
+/**
+ * Prints an error message if memory cannot be allocated and exits the program
+ */
+static void printNullError(void)
+{
+    fprintf(stderr, "error: out of memory\n");
+    exit(EXIT_FAILURE);
+}
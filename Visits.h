@@ -0,0 +1,39 @@
+// Interface to the Visits ADT
+// Counts how many times a team of agents has visited every city, so that
+// detectives using the CHEAPEST_LEAST_VISITED strategy can share one set of
+// counts instead of each keeping its own. Each detective then heads for the
+// cities the whole team has visited least, which spreads the team out, and
+// the team holds one count per city rather than one per city per detective.
+// Counts are added with atomic increments, so agents sharing the counts can
+// make their moves on different threads.
+
+#ifndef VISITS_H
+#define VISITS_H
+
+#include "Allocator.h"
+
+typedef struct visits *Visits;
+
+/**
+ * Creates counts of no visits for the given number of cities. Their memory
+ * comes from the given allocator, or from malloc if it is NULL.
+ * NOTE: The allocator must outlive the counts
+ */
+Visits VisitsNew(int numCities, Allocator allocator);
+
+/**
+ * Frees all memory allocated to the counts
+ */
+void VisitsFree(Visits v);
+
+/**
+ * Counts one more visit to the city
+ */
+void VisitsAdd(Visits v, int city);
+
+/**
+ * Returns the number of visits to the city so far
+ */
+int VisitsCount(Visits v, int city);
+
+#endif
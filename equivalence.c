@@ -0,0 +1,802 @@
+// Differential equivalence harness
+// Plays the same randomly generated games with the reference engine and
+// the optimized engine side by side, checking after every cycle that both
+// engines have moved every agent to the same city with the same stamina,
+// and reports how much faster the optimized engine is for each strategy.
+//
+// Usage: ./equivalence [options]
+//
+// Every trial generates a connected map with random road lengths and
+// informants, a thief and the detectives (four unless -d says otherwise),
+// which all use the strategy being measured, and a seed for the agents'
+// random moves. Every agent has enough stamina for the longest road, as
+// README.md assumes and the reference search needs. With -G the getaway
+// city and the detectives start far from the thief, so games last longer.
+// With -t the optimized engine works out each cycle's moves on a thread
+// pool. With -v the detectives of both games share their visit counts, so
+// with -t as well the pool must not change what the team sees. With -R
+// some roads are closed or change length every few cycles, between the
+// engines' steps, so both engines must repair their DFS routes and least
+// turns paths the same way. Only roads off the random tree are closed, so
+// the map stays connected.
+//
+// Detectives using the COORDINATED strategy search without a limit on the
+// positions searched, so that the optimized engine's transposition table
+// must give the same plans as the reference engine's search without one.
+// The table only finds positions again in searches at least three cycles
+// deep (-D 3).
+//
+// With -b the tip-offs of each cycle are batched in both games, and with -l
+// the optimized engine follows least turns tables for them. Searches with
+// landmarks (-L) or a planning budget (-B) may choose a different path of
+// the same length, so they are checked one search at a time against the
+// reference search instead of in games.
+
+#define _POSIX_C_SOURCE 200809L // for rand_r and clock_gettime
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Agent.h"
+#include "Game.h"
+#include "Landmarks.h"
+#include "Loader.h"
+#include "LeastTurns.h"
+#include "LtpTable.h"
+#include "Map.h"
+#include "Pool.h"
+#include "Team.h"
+
+#define DEFAULT_TRIALS 50
+#define DEFAULT_CITIES 500
+#define DEFAULT_CYCLES 1000
+#define MAX_ROAD_LENGTH 20
+#define EXTRA_ROADS_PER_CITY 2
+#define INFORMANT_PERCENT 10
+#define HUB_ROAD_PERCENT 25
+#define ROAD_CHANGES 5 // roads changed every -R cycles
+#define CLOSE_PERCENT 50 // of the changes that close the road if they can
+#define SEARCHES_PER_MAP 20 // searches checked on each map with -L or -B
+#define FAR_SAMPLES 8 // cities tried for each detective's start with -G
+
+struct options
+{
+    int trials;
+    int numCities;
+    int cycles;
+    unsigned int seed;
+    int numThreads; // 0 to work out the moves on the main thread
+    int numDetectives;
+    int thiefStrategy;
+    int numHubs;
+    bool stacked; // the detectives start in one city with the same stamina
+    int teamDepth;
+    bool sharedVisits;
+    int roadChangeCycles; // 0 if the roads never change
+    bool batchTipOffs;
+    bool ltpTables; // the optimized engine follows least turns tables
+    int numLandmarks; // searches with landmarks are checked if not 0
+    long planningBudget; // searches within a budget are checked if not 0
+    bool longGames; // the agents start far apart
+};
+
+struct timing
+{
+    int games;
+    long cycles;
+    double referenceSeconds;
+    double optimizedSeconds;
+};
+
+static void showUsage(char *program);
+static bool readOptions(int argc, char *argv[], struct options *options);
+
+static Map generateMap(int numCities, int numHubs, int *parent,
+                       unsigned int *rng);
+static void changeRoads(Map m, int *parent, unsigned int *rng);
+static void generateAgents(Map m, struct options *options, int strategy,
+                           struct gameData *data, unsigned int *rng);
+static int farCity(struct costedMove *fromThief, int numCities,
+                   unsigned int *rng);
+static int randomBetween(unsigned int *rng, int low, int high);
+static bool playSideBySide(Map m, int *parent, struct gameData *data,
+                           struct options *options, unsigned int seed,
+                           unsigned int *rng, Pool pool,
+                           struct timing *timing);
+static bool sameAgents(Game reference, Game optimized);
+static bool checkSearches(struct options *options, int *parent);
+static bool checkGoalSearch(Map m, Landmarks l, int city, int goal,
+                            int startStamina, int stamina,
+                            struct costedMove *expected,
+                            struct costedMove *found, struct timing *timing);
+static bool checkBudgetedSearch(Map m, long budget, int city,
+                                int startStamina, int stamina,
+                                struct costedMove *expected,
+                                struct costedMove *found,
+                                struct timing *timing);
+static bool leadsBack(Map m, struct costedMove *found, int from, int city);
+static double now(void);
+
+static int strategies[] = {RANDOM, CHEAPEST_LEAST_VISITED, DFS,
+                           INFORMANT_SEEKING, COORDINATED};
+static char *strategyNames[] = {"RANDOM", "CHEAPEST_LEAST_VISITED", "DFS",
+                                "INFORMANT_SEEKING", "COORDINATED"};
+#define NUM_STRATEGIES 5
+
+int main(int argc, char *argv[])
+{
+    struct options options;
+    if (!readOptions(argc, argv, &options))
+    {
+        showUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Pool pool = NULL;
+    if (options.numThreads > 0)
+    {
+        pool = PoolNew(options.numThreads);
+    }
+
+    int *parent = malloc(options.numCities * sizeof(int));
+    if (parent == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bool allMatched = true;
+    if (options.numLandmarks > 0 || options.planningBudget > 0)
+    {
+        allMatched = checkSearches(&options, parent);
+    }
+    for (int s = 0; s < NUM_STRATEGIES && allMatched; s++)
+    {
+        struct timing timing = {0, 0, 0, 0};
+        for (int trial = 0; trial < options.trials && allMatched; trial++)
+        {
+            // every trial can be repeated on its own from its seed
+            unsigned int trialSeed = options.seed + trial;
+            unsigned int rng = trialSeed;
+            Map m = generateMap(options.numCities, options.numHubs, parent,
+                                &rng);
+            struct gameData data;
+            generateAgents(m, &options, strategies[s], &data, &rng);
+
+            if (!playSideBySide(m, parent, &data, &options, trialSeed, &rng,
+                                pool, &timing))
+            {
+                printf("%s: trial with seed %u does not match\n",
+                       strategyNames[s], trialSeed);
+                allMatched = false;
+            }
+            LoaderFreeAgents(&data);
+            MapFree(m);
+        }
+
+        if (allMatched)
+        {
+            printf("%s: %d games, %ld cycles matched, reference %.3fs, "
+                   "optimized %.3fs, speedup %.2fx\n",
+                   strategyNames[s], timing.games, timing.cycles,
+                   timing.referenceSeconds, timing.optimizedSeconds,
+                   timing.referenceSeconds / timing.optimizedSeconds);
+        }
+    }
+
+    free(parent);
+    if (pool != NULL)
+    {
+        PoolFree(pool);
+    }
+    return allMatched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Prints how to use the program
+ */
+static void showUsage(char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n <trials>  games played per strategy (default %d)\n"
+            "  -c <cities>  number of cities on each map (default %d)\n"
+            "  -g <cycles>  maximum number of cycles per game (default %d)\n"
+            "  -r <seed>    seed of the first trial (default 1)\n"
+            "  -d <number>  number of detectives (default %d, or 1 with -G)\n"
+            "  -T <number>  the thief's strategy (default %d: RANDOM, or\n"
+            "               %d: GETAWAY_SEEKING)\n"
+            "  -t <threads> work out the optimized engine's moves on this\n"
+            "               many threads (default 0: on the main thread)\n"
+            "  -h <hubs>    number of hub cities, each with roads to a\n"
+            "               quarter of the cities (default 0)\n"
+            "  -S           start every detective in the same city with the\n"
+            "               same stamina\n"
+            "  -D <depth>   cycles searched ahead by COORDINATED detectives\n"
+            "               (default %d)\n"
+            "  -v           the detectives share their visit counts\n"
+            "  -R <cycles>  close roads or change their lengths every this\n"
+            "               many cycles (default 0: never)\n"
+            "  -b           batch the tip-offs of each cycle\n"
+            "  -l           give the optimized engine least turns tables\n"
+            "               (implies -b)\n"
+            "  -L <number>  check searches with this many landmarks\n"
+            "  -B <cities>  check searches with this planning budget\n"
+            "  -G           start the getaway city and the detectives far\n"
+            "               from the thief, for long games\n",
+            program, DEFAULT_TRIALS, DEFAULT_CITIES, DEFAULT_CYCLES,
+            NUM_DETECTIVES, RANDOM, GETAWAY_SEEKING, TEAM_DEFAULT_DEPTH);
+}
+
+/**
+ * Reads the options, returning false if any of them is invalid
+ */
+static bool readOptions(int argc, char *argv[], struct options *options)
+{
+    // the number of detectives is 0 until -d gives it, since it depends
+    // on -G otherwise
+    *options = (struct options){DEFAULT_TRIALS, DEFAULT_CITIES,
+                                DEFAULT_CYCLES, 1, 0, 0,
+                                RANDOM, 0, false, TEAM_DEFAULT_DEPTH, false,
+                                0, false, false, 0, 0, false};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-S") == 0)
+        {
+            options->stacked = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            options->sharedVisits = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-G") == 0)
+        {
+            options->longGames = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-b") == 0)
+        {
+            options->batchTipOffs = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-l") == 0)
+        {
+            // tables are only followed by batched tip-offs
+            options->ltpTables = true;
+            options->batchTipOffs = true;
+            continue;
+        }
+        if (i + 1 >= argc || strlen(argv[i]) != 2 || argv[i][0] != '-')
+        {
+            return false;
+        }
+
+        int value = atoi(argv[++i]);
+        switch (argv[i - 1][1])
+        {
+        case 'n': options->trials = value; break;
+        case 'c': options->numCities = value; break;
+        case 'g': options->cycles = value; break;
+        case 'r': options->seed = value; break;
+        case 't': options->numThreads = value; break;
+        case 'd': options->numDetectives = value; break;
+        case 'T': options->thiefStrategy = value; break;
+        case 'h': options->numHubs = value; break;
+        case 'D': options->teamDepth = value; break;
+        case 'R': options->roadChangeCycles = value; break;
+        case 'L': options->numLandmarks = value; break;
+        case 'B': options->planningBudget = value; break;
+        default: return false;
+        }
+    }
+
+    if (options->numDetectives == 0)
+    {
+        options->numDetectives = options->longGames ? 1 : NUM_DETECTIVES;
+    }
+    return options->trials > 0 && options->numCities > 1 &&
+           options->cycles > 0 && options->numThreads >= 0 &&
+           options->numDetectives > 0 && options->numHubs >= 0 &&
+           options->numHubs <= options->numCities &&
+           options->teamDepth > 0 && options->roadChangeCycles >= 0 &&
+           options->numLandmarks >= 0 && options->planningBudget >= 0 &&
+           (options->thiefStrategy == RANDOM ||
+            options->thiefStrategy == GETAWAY_SEEKING);
+}
+
+/**
+ * Generates a random connected map: a random tree joining every city plus
+ * some extra roads between random cities, and roads from the first
+ * `numHubs` cities to a quarter of the cities. Each city's parent in the
+ * tree is stored in `parent` (-1 for city 0).
+ */
+static Map generateMap(int numCities, int numHubs, int *parent,
+                       unsigned int *rng)
+{
+    Map m = MapNew(numCities);
+    parent[0] = -1;
+    for (int city = 1; city < numCities; city++)
+    {
+        parent[city] = randomBetween(rng, 0, city - 1);
+        MapInsertRoad(m, city, parent[city],
+                      randomBetween(rng, 1, MAX_ROAD_LENGTH));
+    }
+    for (int i = 0; i < numCities * EXTRA_ROADS_PER_CITY; i++)
+    {
+        int city1 = randomBetween(rng, 0, numCities - 1);
+        int city2 = randomBetween(rng, 0, numCities - 1);
+        if (city1 != city2)
+        {
+            MapInsertRoad(m, city1, city2,
+                          randomBetween(rng, 1, MAX_ROAD_LENGTH));
+        }
+    }
+
+    for (int hub = 0; hub < numHubs; hub++)
+    {
+        for (int city = 0; city < numCities; city++)
+        {
+            if (city != hub && randomBetween(rng, 1, 100) <= HUB_ROAD_PERCENT)
+            {
+                MapInsertRoad(m, hub, city,
+                              randomBetween(rng, 1, MAX_ROAD_LENGTH));
+            }
+        }
+    }
+
+    for (int city = 0; city < numCities; city++)
+    {
+        MapSetInformant(m, city,
+                        randomBetween(rng, 1, 100) <= INFORMANT_PERCENT);
+    }
+    return m;
+}
+
+/**
+ * Closes or changes the length of a few random roads. Roads of the tree
+ * given by `parent` only ever change length, so every city can still be
+ * reached.
+ */
+static void changeRoads(Map m, int *parent, unsigned int *rng)
+{
+    struct road *roads = malloc(MapNumCities(m) * sizeof(struct road));
+    if (roads == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < ROAD_CHANGES; i++)
+    {
+        int city = randomBetween(rng, 0, MapNumCities(m) - 1);
+        int numRoads = MapGetRoadsFrom(m, city, roads);
+        if (numRoads == 0)
+        {
+            continue;
+        }
+        struct road r = roads[randomBetween(rng, 0, numRoads - 1)];
+        bool inTree = parent[r.from] == r.to || parent[r.to] == r.from;
+        if (!inTree && randomBetween(rng, 1, 100) <= CLOSE_PERCENT)
+        {
+            MapRemoveRoad(m, r.from, r.to);
+        }
+        else
+        {
+            MapSetRoadLength(m, r.from, r.to,
+                             randomBetween(rng, 1, MAX_ROAD_LENGTH));
+        }
+    }
+    free(roads);
+}
+
+/**
+ * Generates a thief and the detectives, who all use the given strategy. If
+ * the detectives are stacked, every detective is a copy of the first one.
+ * For long games the getaway city is the one the thief needs the most turns
+ * to reach, and each detective starts in the farthest from the thief of a
+ * few random cities.
+ * NOTE: The detectives must be freed with LoaderFreeAgents
+ */
+static void generateAgents(Map m, struct options *options, int strategy,
+                           struct gameData *data, unsigned int *rng)
+{
+    int numCities = options->numCities;
+    data->thief.stamina = randomBetween(rng, MAX_ROAD_LENGTH,
+                                        3 * MAX_ROAD_LENGTH);
+    data->thief.start = randomBetween(rng, 0, numCities - 1);
+    data->thief.strategy = options->thiefStrategy;
+    strcpy(data->thief.name, "Thief");
+    data->getaway = randomBetween(rng, 0, numCities - 1);
+
+    struct costedMove *fromThief = NULL;
+    if (options->longGames)
+    {
+        fromThief = malloc(numCities * sizeof(struct costedMove));
+        if (fromThief == NULL)
+        {
+            fprintf(stderr, "error: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        LeastTurnsSearch(m, data->thief.start, data->thief.stamina,
+                         data->thief.stamina, fromThief);
+        for (int city = 0; city < numCities; city++)
+        {
+            if (fromThief[city].numMovesTaken != INT_MAX &&
+                fromThief[city].numMovesTaken >
+                    fromThief[data->getaway].numMovesTaken)
+            {
+                data->getaway = city;
+            }
+        }
+    }
+
+    int numDetectives = options->numDetectives;
+    data->numDetectives = numDetectives;
+    data->detectives = malloc(numDetectives * sizeof(struct agentData));
+    if (data->detectives == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int d = 0; d < numDetectives; d++)
+    {
+        struct agentData *detective = &data->detectives[d];
+        if (options->stacked && d > 0)
+        {
+            *detective = data->detectives[0];
+        }
+        else
+        {
+            detective->stamina = randomBetween(rng, MAX_ROAD_LENGTH,
+                                               3 * MAX_ROAD_LENGTH);
+            detective->start = fromThief != NULL
+                                   ? farCity(fromThief, numCities, rng)
+                                   : randomBetween(rng, 0, numCities - 1);
+        }
+        detective->strategy = strategy;
+        snprintf(detective->name, sizeof(detective->name), "D%d", d + 1);
+    }
+    free(fromThief);
+}
+
+/**
+ * Returns the one of a few random cities that the thief needs the most
+ * turns to reach
+ */
+static int farCity(struct costedMove *fromThief, int numCities,
+                   unsigned int *rng)
+{
+    int far = randomBetween(rng, 0, numCities - 1);
+    for (int i = 1; i < FAR_SAMPLES; i++)
+    {
+        int city = randomBetween(rng, 0, numCities - 1);
+        if (fromThief[city].numMovesTaken > fromThief[far].numMovesTaken)
+        {
+            far = city;
+        }
+    }
+    return far;
+}
+
+/**
+ * Returns a random number between low and high inclusive
+ */
+static int randomBetween(unsigned int *rng, int low, int high)
+{
+    return low + rand_r(rng) % (high - low + 1);
+}
+
+/**
+ * Plays the game with both engines one cycle at a time, changing the roads
+ * between cycles if asked to, and returns false as soon as they disagree
+ */
+static bool playSideBySide(Map m, int *parent, struct gameData *data,
+                           struct options *options, unsigned int seed,
+                           unsigned int *rng, Pool pool,
+                           struct timing *timing)
+{
+    Game reference = GameNew(m, data, options->cycles, seed);
+    Game optimized = GameNew(m, data, options->cycles, seed);
+    GameSetEngine(reference, ENGINE_REFERENCE);
+    GameSetEngine(optimized, ENGINE_OPTIMIZED);
+    GameSetPool(optimized, pool);
+    GameSetSharedVisits(reference, options->sharedVisits);
+    GameSetSharedVisits(optimized, options->sharedVisits);
+    GameSetTeamSearch(reference, options->teamDepth, 0, LONG_MAX);
+    GameSetTeamSearch(optimized, options->teamDepth, TEAM_DEFAULT_TABLE_BYTES,
+                      LONG_MAX);
+    GameSetBatchTipOffs(reference, options->batchTipOffs);
+    GameSetBatchTipOffs(optimized, options->batchTipOffs);
+
+    // tables are made before the game, as if they had been loaded with
+    // the map, so they are not timed
+    LtpTable tables[data->numDetectives];
+    int numTables = 0;
+    for (int d = 0; d < data->numDetectives && options->ltpTables; d++)
+    {
+        bool built = false;
+        for (int t = 0; t < numTables && !built; t++)
+        {
+            built = LtpTableStamina(tables[t]) == data->detectives[d].stamina;
+        }
+        if (!built)
+        {
+            tables[numTables] = LtpTableBuild(m, data->detectives[d].stamina);
+            GameSetLtpTable(optimized, tables[numTables++]);
+        }
+    }
+
+    bool matched = true;
+    while (matched && GameState(reference) == GAME_RUNNING)
+    {
+        double start = now();
+        GameStep(reference);
+        double middle = now();
+        GameStep(optimized);
+        double end = now();
+        timing->referenceSeconds += middle - start;
+        timing->optimizedSeconds += end - middle;
+
+        matched = sameAgents(reference, optimized);
+        if (!matched)
+        {
+            printf("cycle %d: the engines disagree\n", GameCycle(reference));
+        }
+        if (options->roadChangeCycles > 0 &&
+            GameCycle(reference) % options->roadChangeCycles == 0)
+        {
+            changeRoads(m, parent, rng);
+        }
+    }
+    matched = matched && GameState(reference) == GameState(optimized);
+
+    timing->games++;
+    timing->cycles += GameCycle(reference);
+    GameFree(reference);
+    GameFree(optimized);
+    for (int t = 0; t < numTables; t++)
+    {
+        LtpTableFree(tables[t]);
+    }
+    return matched;
+}
+
+/**
+ * Returns true if every agent is in the same city with the same stamina in
+ * both games, printing the agents that differ otherwise
+ */
+static bool sameAgents(Game reference, Game optimized)
+{
+    bool same = true;
+    for (int i = 0; i < GameNumAgents(reference); i++)
+    {
+        Agent x = GameAgent(reference, i);
+        Agent y = GameAgent(optimized, i);
+        if (AgentLocation(x) != AgentLocation(y) ||
+            AgentStamina(x) != AgentStamina(y))
+        {
+            printf("  %s: reference at %d with %d stamina, optimized at %d "
+                   "with %d stamina\n", AgentName(x), AgentLocation(x),
+                   AgentStamina(x), AgentLocation(y), AgentStamina(y));
+            same = false;
+        }
+    }
+    return same;
+}
+
+/**
+ * Checks searches between random cities on every trial's map: with -L,
+ * that a search with landmarks finds a path to the goal with the same turns
+ * and stamina as the reference search, and with -B, that every path of a
+ * search carried out within the budget leads back to the starting city
+ * whenever the search stops, and that it ends with the same paths as the
+ * reference search. Returns false at the first
+ * search that does not.
+ */
+static bool checkSearches(struct options *options, int *parent)
+{
+    struct costedMove *expected = malloc(options->numCities *
+                                         sizeof(struct costedMove));
+    struct costedMove *found = malloc(options->numCities *
+                                      sizeof(struct costedMove));
+    if (expected == NULL || found == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct timing goalTiming = {0, 0, 0, 0};
+    struct timing budgetTiming = {0, 0, 0, 0};
+    bool allMatched = true;
+    for (int trial = 0; trial < options->trials && allMatched; trial++)
+    {
+        unsigned int trialSeed = options->seed + trial;
+        unsigned int rng = trialSeed;
+        Map m = generateMap(options->numCities, options->numHubs, parent,
+                            &rng);
+        Landmarks l = NULL;
+        if (options->numLandmarks > 0)
+        {
+            l = LandmarksNew(m, options->numLandmarks);
+        }
+
+        for (int i = 0; i < SEARCHES_PER_MAP && allMatched; i++)
+        {
+            int city = randomBetween(&rng, 0, options->numCities - 1);
+            int goal = randomBetween(&rng, 0, options->numCities - 1);
+            int stamina = randomBetween(&rng, MAX_ROAD_LENGTH,
+                                        3 * MAX_ROAD_LENGTH);
+            int startStamina = randomBetween(&rng, 0, stamina);
+
+            double start = now();
+            LeastTurnsReferenceSearch(m, city, startStamina, stamina,
+                                      expected);
+            double referenceSeconds = now() - start;
+
+            if (l != NULL)
+            {
+                goalTiming.referenceSeconds += referenceSeconds;
+                allMatched = checkGoalSearch(m, l, city, goal, startStamina,
+                                             stamina, expected, found,
+                                             &goalTiming);
+            }
+            if (allMatched && options->planningBudget > 0)
+            {
+                budgetTiming.referenceSeconds += referenceSeconds;
+                allMatched = checkBudgetedSearch(m, options->planningBudget,
+                                                 city, startStamina, stamina,
+                                                 expected, found,
+                                                 &budgetTiming);
+            }
+            if (!allMatched)
+            {
+                printf("search from %d with %d of %d stamina in trial with "
+                       "seed %u does not match\n", city, startStamina,
+                       stamina, trialSeed);
+            }
+        }
+
+        if (l != NULL)
+        {
+            LandmarksFree(l);
+        }
+        MapFree(m);
+    }
+
+    if (allMatched && options->numLandmarks > 0)
+    {
+        printf("landmarks: %d searches matched, reference %.3fs, "
+               "optimized %.3fs, speedup %.2fx\n", goalTiming.games,
+               goalTiming.referenceSeconds, goalTiming.optimizedSeconds,
+               goalTiming.referenceSeconds / goalTiming.optimizedSeconds);
+    }
+    if (allMatched && options->planningBudget > 0)
+    {
+        printf("planning budget: %d searches matched, reference %.3fs, "
+               "budgeted %.3fs\n", budgetTiming.games,
+               budgetTiming.referenceSeconds, budgetTiming.optimizedSeconds);
+    }
+    free(expected);
+    free(found);
+    return allMatched;
+}
+
+/**
+ * Returns true if a search with landmarks gives the goal the turns and
+ * stamina of the reference search, along a path of roads that leads back to
+ * the starting city
+ */
+static bool checkGoalSearch(Map m, Landmarks l, int city, int goal,
+                            int startStamina, int stamina,
+                            struct costedMove *expected,
+                            struct costedMove *found, struct timing *timing)
+{
+    double start = now();
+    LeastTurnsGoalSearch(m, city, goal, startStamina, stamina, l, found);
+    timing->optimizedSeconds += now() - start;
+    timing->games++;
+
+    if (found[goal].numMovesTaken != expected[goal].numMovesTaken ||
+        (found[goal].numMovesTaken != INT_MAX &&
+         found[goal].remainingStamina != expected[goal].remainingStamina))
+    {
+        printf("  goal %d: reference %d turns with %d stamina, landmarks %d "
+               "turns with %d stamina\n", goal,
+               expected[goal].numMovesTaken, expected[goal].remainingStamina,
+               found[goal].numMovesTaken, found[goal].remainingStamina);
+        return false;
+    }
+
+    return found[goal].numMovesTaken == INT_MAX ||
+           leadsBack(m, found, goal, city);
+}
+
+/**
+ * Returns true if every path of a search carried out `budget` cities at a
+ * time leads back to the starting city whenever it stops, and the search
+ * ends with the same paths as the reference search
+ */
+static bool checkBudgetedSearch(Map m, long budget, int city,
+                                int startStamina, int stamina,
+                                struct costedMove *expected,
+                                struct costedMove *found,
+                                struct timing *timing)
+{
+    int numCities = MapNumCities(m);
+    double start = now();
+    PartialSearch s = LeastTurnsStartSearch(m, city, startStamina, stamina,
+                                            found);
+    bool finished = false;
+    while (!finished)
+    {
+        finished = LeastTurnsContinueSearch(s, budget);
+        timing->optimizedSeconds += now() - start;
+        for (int c = 0; c < numCities; c++)
+        {
+            if (found[c].numMovesTaken != INT_MAX &&
+                !leadsBack(m, found, c, city))
+            {
+                LeastTurnsFreeSearch(s);
+                return false;
+            }
+        }
+        start = now();
+    }
+    LeastTurnsFreeSearch(s);
+    timing->games++;
+
+    for (int c = 0; c < numCities; c++)
+    {
+        if (found[c].numMovesTaken != expected[c].numMovesTaken ||
+            (found[c].numMovesTaken != INT_MAX &&
+             (found[c].remainingStamina != expected[c].remainingStamina ||
+              found[c].m.to != expected[c].m.to)))
+        {
+            printf("  city %d: reference %d turns with %d stamina from %d, "
+                   "budgeted %d turns with %d stamina from %d\n", c,
+                   expected[c].numMovesTaken, expected[c].remainingStamina,
+                   expected[c].m.to, found[c].numMovesTaken,
+                   found[c].remainingStamina, found[c].m.to);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if following the path back from `from` leads along roads of
+ * the lengths recorded to `city`, printing where it breaks otherwise
+ */
+static bool leadsBack(Map m, struct costedMove *found, int from, int city)
+{
+    int steps = 0;
+    for (int at = from; at != city; at = found[at].m.to)
+    {
+        if (++steps > MapNumCities(m) || found[at].m.to < 0 ||
+            MapContainsRoad(m, at, found[at].m.to) != found[at].m.staminaCost)
+        {
+            printf("  the path back from %d to %d breaks at %d\n", from,
+                   city, at);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns the current time in seconds
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
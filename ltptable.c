@@ -0,0 +1,72 @@
+// Least turns table builder
+// Builds the least turns table for a map and a detective stamina and saves
+// it, so that later runs can load it instead of searching (see LtpTable.h).
+//
+// Usage: ./ltptable <city data file> <stamina> <table file>
+//
+// If the table file already holds a valid table for the map and stamina it
+// is left alone.
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Loader.h"
+#include "LtpTable.h"
+#include "Map.h"
+
+static double now(void);
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4 || atoi(argv[2]) <= 0)
+    {
+        fprintf(stderr, "usage: %s <city data file> <stamina> <table file>\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Map m = LoaderReadCities(argv[1]);
+    if (m == NULL)
+    {
+        fprintf(stderr, "error: couldn't read city data from '%s'\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    int stamina = atoi(argv[2]);
+
+    double start = now();
+    LtpTable t = LtpTableLoad(m, stamina, argv[3]);
+    if (t != NULL)
+    {
+        printf("'%s' is already up to date (loaded in %.3fs)\n", argv[3],
+               now() - start);
+    }
+    else
+    {
+        t = LtpTableBuild(m, stamina);
+        if (!LtpTableSave(t, argv[3]))
+        {
+            fprintf(stderr, "error: couldn't write '%s'\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+        printf("built '%s' for %d cities in %.3fs\n", argv[3],
+               MapNumCities(m), now() - start);
+    }
+
+    LtpTableFree(t);
+    MapFree(m);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the current time in seconds
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
@@ -0,0 +1,614 @@
+// Detective start placement optimizer
+// Plays many seeded games for every combination of detective start cities
+// (and optionally strategies) drawn from a set of candidate cities, and
+// reports the combinations that catch the thief most often.
+//
+// Usage: ./placement <city data file> <agent data file> <cycles> [options]
+//
+// Detectives with the same maximum stamina (and the same strategy, unless
+// strategies are being tried) are interchangeable, so only one order of
+// their choices is tried: swapping two of them changes nothing but which
+// of them uses which random number generator.
+//
+// Games are played in rounds on a work-stealing thread pool which shares
+// one map. Every placement plays the same seeds, and after each round any
+// placement whose catch rate is clearly below the best one (their
+// Hoeffding confidence intervals no longer overlap) is dropped. A round in
+// which every agent moves at random or stays put is played in lockstep
+// (see Lockstep.h).
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Agent.h"
+#include "Game.h"
+#include "Loader.h"
+#include "Lockstep.h"
+#include "Map.h"
+#include "Pool.h"
+
+#define DEFAULT_GAMES 100
+#define DEFAULT_CANDIDATES 8
+#define DEFAULT_TOP 5
+#define GAMES_PER_ROUND 10
+#define CONFIDENCE 0.05 // chance of wrongly dropping a placement per round
+#define MAX_DETECTIVES NUM_DETECTIVES // placements grow exponentially with
+                                      // the number of detectives
+#define MAX_PLACEMENTS 1000000
+
+struct options
+{
+    int games;
+    int numCandidates;
+    bool tryStrategies;
+    int numThreads;
+    int top;
+    unsigned int firstSeed;
+    bool thiefSeeksGetaway;
+};
+
+// A placement is a start city and strategy for every detective
+struct placement
+{
+    int start[MAX_DETECTIVES];
+    int strategy[MAX_DETECTIVES];
+    int gamesPlayed;
+    int numCaught;
+    long totalCycles; // cycles taken by the games in which the thief was caught
+    bool dropped;
+};
+
+// A round of games for one placement, run as a single task
+struct roundTask
+{
+    Map map;
+    Lockstep lockstep;
+    struct gameData *data;
+    int cycles;
+    struct placement *placement;
+    unsigned int firstSeed;
+    int numGames;
+};
+
+static void showUsage(char *program);
+static bool readOptions(int argc, char *argv[], struct options *options);
+
+static int *chooseCandidates(Map m, int thiefStart, int numCandidates);
+static struct placement *makePlacements(int *candidates, int numCandidates,
+                                        struct gameData *data,
+                                        bool tryStrategies,
+                                        long *numPlacements);
+static void findInterchangeable(struct gameData *data, bool tryStrategies,
+                                int previous[]);
+static long countPlacements(long numChoices, int numDetectives,
+                            int previous[]);
+static void addPlacements(struct placement *placements, long *numPlacements,
+                          int choices[], int detective, int *candidates,
+                          long numChoices, int numStrategies,
+                          struct gameData *data, int previous[]);
+static void playRound(void *arg);
+static int dropDominated(struct placement *placements, long numPlacements);
+static double catchRate(struct placement *p);
+static int comparePlacements(const void *a, const void *b);
+static void showPlacement(Map m, struct gameData *data, struct placement *p,
+                          int rank);
+
+static int strategies[] = {RANDOM, CHEAPEST_LEAST_VISITED, DFS,
+                           INFORMANT_SEEKING, COORDINATED};
+static char *strategyNames[] = {"RANDOM", "CHEAPEST_LEAST_VISITED", "DFS",
+                                "INFORMANT_SEEKING", "COORDINATED"};
+#define NUM_STRATEGIES 5
+
+int main(int argc, char *argv[])
+{
+    struct options options;
+    if (argc < 4 || !readOptions(argc, argv, &options))
+    {
+        showUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Pool pool = PoolNew(options.numThreads);
+    Map m = LoaderReadCitiesParallel(argv[1], pool);
+    if (m == NULL)
+    {
+        fprintf(stderr, "error: couldn't read city data from '%s'\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    struct gameData data;
+    if (!LoaderReadAgents(argv[2], &data))
+    {
+        fprintf(stderr, "error: couldn't read agent data from '%s'\n",
+                argv[2]);
+        return EXIT_FAILURE;
+    }
+    int cycles = atoi(argv[3]);
+    if (options.thiefSeeksGetaway)
+    {
+        data.thief.strategy = GETAWAY_SEEKING;
+    }
+    char *reason = LoaderCheckAgents(m, &data);
+    if (reason != NULL)
+    {
+        fprintf(stderr, "error: '%s' does not fit the map: %s\n", argv[2],
+                reason);
+        return EXIT_FAILURE;
+    }
+    if (data.numDetectives > MAX_DETECTIVES)
+    {
+        fprintf(stderr, "error: can only place up to %d detectives\n",
+                MAX_DETECTIVES);
+        return EXIT_FAILURE;
+    }
+
+    if (options.numCandidates > MapNumCities(m) - 1)
+    {
+        options.numCandidates = MapNumCities(m) - 1;
+    }
+    if (options.numCandidates <= 0)
+    {
+        fprintf(stderr, "error: there are no cities to start detectives in\n");
+        return EXIT_FAILURE;
+    }
+    int *candidates = chooseCandidates(m, data.thief.start,
+                                       options.numCandidates);
+    long numPlacements;
+    struct placement *placements = makePlacements(candidates,
+                                                  options.numCandidates, &data,
+                                                  options.tryStrategies,
+                                                  &numPlacements);
+    printf("Evaluating %ld placements on %d threads\n", numPlacements,
+           options.numThreads);
+
+    Lockstep lockstep = LockstepNew(m);
+    struct roundTask *tasks = malloc(numPlacements * sizeof(struct roundTask));
+    if (tasks == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int played = 0; played < options.games; played += GAMES_PER_ROUND)
+    {
+        int numGames = options.games - played < GAMES_PER_ROUND
+                           ? options.games - played
+                           : GAMES_PER_ROUND;
+        for (long i = 0; i < numPlacements; i++)
+        {
+            if (!placements[i].dropped)
+            {
+                tasks[i] = (struct roundTask){m, lockstep, &data, cycles,
+                                              &placements[i],
+                                              options.firstSeed + played,
+                                              numGames};
+                PoolSubmit(pool, playRound, &tasks[i]);
+            }
+        }
+        PoolWait(pool);
+
+        int numDropped = dropDominated(placements, numPlacements);
+        if (numDropped > 0)
+        {
+            printf("After %d games: dropped %d dominated placements\n",
+                   played + numGames, numDropped);
+        }
+    }
+
+    qsort(placements, numPlacements, sizeof(struct placement),
+          comparePlacements);
+    for (int i = 0; i < options.top && i < numPlacements; i++)
+    {
+        showPlacement(m, &data, &placements[i], i + 1);
+    }
+
+    PoolFree(pool);
+    LockstepFree(lockstep);
+    free(tasks);
+    free(placements);
+    free(candidates);
+    LoaderFreeAgents(&data);
+    MapFree(m);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Prints how to use the program
+ */
+static void showUsage(char *program)
+{
+    fprintf(stderr,
+            "usage: %s <city data file> <agent data file> <cycles> "
+            "[options]\n"
+            "  -g <games>   games played by each placement (default %d)\n"
+            "  -c <cities>  number of candidate start cities (default %d)\n"
+            "  -s           also try every strategy for every detective\n"
+            "  -e           the thief heads for the getaway city instead of\n"
+            "               moving randomly\n"
+            "  -t <threads> number of worker threads (default: one per "
+            "processor)\n"
+            "  -k <top>     number of placements to report (default %d)\n"
+            "  -r <seed>    seed of the first game (default 1)\n",
+            program, DEFAULT_GAMES, DEFAULT_CANDIDATES, DEFAULT_TOP);
+}
+
+/**
+ * Reads the options after the three required arguments, returning false if
+ * any of them is invalid
+ */
+static bool readOptions(int argc, char *argv[], struct options *options)
+{
+    *options = (struct options){DEFAULT_GAMES, DEFAULT_CANDIDATES, false,
+                                PoolDefaultNumThreads(), DEFAULT_TOP, 1,
+                                false};
+
+    for (int i = 4; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0)
+        {
+            options->tryStrategies = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-e") == 0)
+        {
+            options->thiefSeeksGetaway = true;
+            continue;
+        }
+        if (i + 1 >= argc || strlen(argv[i]) != 2 || argv[i][0] != '-')
+        {
+            return false;
+        }
+
+        int value = atoi(argv[++i]);
+        switch (argv[i - 1][1])
+        {
+        case 'g': options->games = value; break;
+        case 'c': options->numCandidates = value; break;
+        case 't': options->numThreads = value; break;
+        case 'k': options->top = value; break;
+        case 'r': options->firstSeed = value; break;
+        default: return false;
+        }
+    }
+
+    return options->games > 0 && options->numCandidates > 0 &&
+           options->numThreads > 0 && options->top > 0;
+}
+
+/**
+ * Chooses the candidate start cities: informant cities first, as a detective
+ * starting there is tipped off straight away, then the cities with the most
+ * roads, then the cities with the lowest IDs. The thief's starting city is
+ * left out since starting there would catch the thief before the game
+ * begins.
+ */
+static int *chooseCandidates(Map m, int thiefStart, int numCandidates)
+{
+    int numCities = MapNumCities(m);
+    int *candidates = malloc(numCandidates * sizeof(int));
+    struct road *roads = malloc(numCities * sizeof(struct road));
+    int *score = malloc(numCities * sizeof(int));
+    bool *chosen = calloc(numCities, sizeof(bool));
+    if (candidates == NULL || roads == NULL || score == NULL || chosen == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < numCities; i++)
+    {
+        score[i] = MapGetRoadsFrom(m, i, roads) +
+                   (MapHasInformant(m, i) ? numCities : 0);
+    }
+    chosen[thiefStart] = true;
+    for (int c = 0; c < numCandidates; c++)
+    {
+        int best = -1;
+        for (int i = 0; i < numCities; i++)
+        {
+            if (!chosen[i] && (best == -1 || score[i] > score[best]))
+            {
+                best = i;
+            }
+        }
+        chosen[best] = true;
+        candidates[c] = best;
+    }
+
+    free(chosen);
+    free(score);
+    free(roads);
+    return candidates;
+}
+
+/**
+ * Creates every combination of a candidate city (and strategy, if they are
+ * being tried) for each detective, leaving out reorderings of the choices
+ * of interchangeable detectives. Exits with an error if there would be
+ * more than MAX_PLACEMENTS of them.
+ */
+static struct placement *makePlacements(int *candidates, int numCandidates,
+                                        struct gameData *data,
+                                        bool tryStrategies,
+                                        long *numPlacements)
+{
+    int numStrategies = tryStrategies ? NUM_STRATEGIES : 1;
+    long numChoices = (long)numCandidates * numStrategies;
+    int previous[MAX_DETECTIVES];
+    findInterchangeable(data, tryStrategies, previous);
+
+    long total = countPlacements(numChoices, data->numDetectives, previous);
+    if (total < 0)
+    {
+        fprintf(stderr, "error: more than %d placements to try; use fewer "
+                "candidate cities (-c) or detectives\n", MAX_PLACEMENTS);
+        exit(EXIT_FAILURE);
+    }
+
+    struct placement *placements = malloc(total * sizeof(struct placement));
+    if (placements == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int choices[MAX_DETECTIVES];
+    *numPlacements = 0;
+    addPlacements(placements, numPlacements, choices, 0, candidates,
+                  numChoices, numStrategies, data, previous);
+    assert(*numPlacements == total);
+    return placements;
+}
+
+/**
+ * Sets `previous[d]` to the last detective before detective d that is
+ * interchangeable with it, or -1 if there is none. Detectives are
+ * interchangeable if they have the same maximum stamina and, when
+ * strategies are not being tried, the same strategy.
+ */
+static void findInterchangeable(struct gameData *data, bool tryStrategies,
+                                int previous[])
+{
+    for (int d = 0; d < data->numDetectives; d++)
+    {
+        struct agentData *x = &data->detectives[d];
+        previous[d] = -1;
+        for (int e = d - 1; e >= 0 && previous[d] == -1; e--)
+        {
+            struct agentData *y = &data->detectives[e];
+            if (x->stamina == y->stamina &&
+                (tryStrategies || x->strategy == y->strategy))
+            {
+                previous[d] = e;
+            }
+        }
+    }
+}
+
+/**
+ * Returns the number of placements, where each group of k interchangeable
+ * detectives has C(numChoices + k - 1, k) ways to choose, or -1 if there
+ * are more than MAX_PLACEMENTS
+ */
+static long countPlacements(long numChoices, int numDetectives,
+                            int previous[])
+{
+    // the ways a group can choose are built up one detective at a time,
+    // and each step is exact since it is itself a binomial coefficient
+    long total = 1;
+    long ways[MAX_DETECTIVES];
+    int groupSize[MAX_DETECTIVES] = {0};
+    int first[MAX_DETECTIVES];
+    for (int d = 0; d < numDetectives; d++)
+    {
+        int g = first[d] = previous[d] == -1 ? d : first[previous[d]];
+        int k = ++groupSize[g];
+        ways[g] = k == 1 ? numChoices : ways[g] * (numChoices + k - 1) / k;
+        if (ways[g] > MAX_PLACEMENTS)
+        {
+            return -1;
+        }
+    }
+
+    for (int d = 0; d < numDetectives; d++)
+    {
+        if (previous[d] == -1)
+        {
+            if (total > MAX_PLACEMENTS / ways[d])
+            {
+                return -1;
+            }
+            total *= ways[d];
+        }
+    }
+    return total;
+}
+
+/**
+ * Adds a placement for every way of choosing for detective `detective` and
+ * the detectives after it, given the choices of the ones before it. An
+ * interchangeable detective never makes an earlier choice than the one
+ * before it, so each set of choices is tried in one order only.
+ */
+static void addPlacements(struct placement *placements, long *numPlacements,
+                          int choices[], int detective, int *candidates,
+                          long numChoices, int numStrategies,
+                          struct gameData *data, int previous[])
+{
+    if (detective == data->numDetectives)
+    {
+        struct placement *p = &placements[(*numPlacements)++];
+        for (int d = 0; d < data->numDetectives; d++)
+        {
+            p->start[d] = candidates[choices[d] / numStrategies];
+            p->strategy[d] = numStrategies > 1
+                                 ? strategies[choices[d] % numStrategies]
+                                 : data->detectives[d].strategy;
+        }
+        p->gamesPlayed = 0;
+        p->numCaught = 0;
+        p->totalCycles = 0;
+        p->dropped = false;
+        return;
+    }
+
+    int first = previous[detective] == -1 ? 0 : choices[previous[detective]];
+    for (int choice = first; choice < numChoices; choice++)
+    {
+        choices[detective] = choice;
+        addPlacements(placements, numPlacements, choices, detective + 1,
+                      candidates, numChoices, numStrategies, data, previous);
+    }
+}
+
+/**
+ * Plays a round of games for one placement
+ */
+static void playRound(void *arg)
+{
+    struct roundTask *task = arg;
+    struct placement *p = task->placement;
+
+    struct gameData data = *task->data;
+    struct agentData detectives[MAX_DETECTIVES];
+    data.detectives = detectives;
+    for (int d = 0; d < data.numDetectives; d++)
+    {
+        detectives[d] = task->data->detectives[d];
+        detectives[d].start = p->start[d];
+        detectives[d].strategy = p->strategy[d];
+    }
+
+    unsigned int seeds[GAMES_PER_ROUND];
+    int states[GAMES_PER_ROUND];
+    int cycles[GAMES_PER_ROUND];
+    for (int i = 0; i < task->numGames; i++)
+    {
+        seeds[i] = task->firstSeed + i;
+    }
+    if (!LockstepRun(task->lockstep, &data, task->cycles, seeds,
+                     task->numGames, states, cycles))
+    {
+        for (int i = 0; i < task->numGames; i++)
+        {
+            Game g = GameNew(task->map, &data, task->cycles, seeds[i]);
+            states[i] = GameRun(g);
+            cycles[i] = GameCycle(g);
+            GameFree(g);
+        }
+    }
+
+    for (int i = 0; i < task->numGames; i++)
+    {
+        if (states[i] == GAME_CAUGHT)
+        {
+            p->numCaught++;
+            p->totalCycles += cycles[i];
+        }
+        p->gamesPlayed++;
+    }
+}
+
+/**
+ * Drops every placement whose upper confidence bound on its catch rate is
+ * below the best lower confidence bound, and returns how many were dropped
+ */
+static int dropDominated(struct placement *placements, long numPlacements)
+{
+    double bestLower = 0;
+    for (long i = 0; i < numPlacements; i++)
+    {
+        struct placement *p = &placements[i];
+        if (!p->dropped)
+        {
+            double margin = sqrt(log(2 / CONFIDENCE) / (2 * p->gamesPlayed));
+            if (catchRate(p) - margin > bestLower)
+            {
+                bestLower = catchRate(p) - margin;
+            }
+        }
+    }
+
+    int numDropped = 0;
+    for (long i = 0; i < numPlacements; i++)
+    {
+        struct placement *p = &placements[i];
+        if (!p->dropped)
+        {
+            double margin = sqrt(log(2 / CONFIDENCE) / (2 * p->gamesPlayed));
+            if (catchRate(p) + margin < bestLower)
+            {
+                p->dropped = true;
+                numDropped++;
+            }
+        }
+    }
+    return numDropped;
+}
+
+/**
+ * Returns the fraction of the placement's games in which the thief was
+ * caught
+ */
+static double catchRate(struct placement *p)
+{
+    return p->gamesPlayed == 0 ? 0 : (double)p->numCaught / p->gamesPlayed;
+}
+
+/**
+ * Comparison function used by qsort that puts placements that were never
+ * dropped first, then the highest catch rates, then the fastest catches
+ */
+static int comparePlacements(const void *a, const void *b)
+{
+    struct placement *x = (struct placement *)a;
+    struct placement *y = (struct placement *)b;
+    if (x->dropped != y->dropped)
+    {
+        return x->dropped - y->dropped;
+    }
+    // compare x->numCaught / x->gamesPlayed with y's without dividing
+    long lhs = (long)y->numCaught * x->gamesPlayed;
+    long rhs = (long)x->numCaught * y->gamesPlayed;
+    if (lhs != rhs)
+    {
+        return lhs < rhs ? -1 : 1;
+    }
+    long xCycles = x->totalCycles * (y->numCaught > 0 ? y->numCaught : 1);
+    long yCycles = y->totalCycles * (x->numCaught > 0 ? x->numCaught : 1);
+    return (xCycles > yCycles) - (xCycles < yCycles);
+}
+
+/**
+ * Prints a placement's catch rate and where each detective starts
+ */
+static void showPlacement(Map m, struct gameData *data, struct placement *p,
+                          int rank)
+{
+    printf("%d. caught in %d of %d games (%.1f%%)", rank, p->numCaught,
+           p->gamesPlayed, 100 * catchRate(p));
+    if (p->numCaught > 0)
+    {
+        printf(", after %.1f cycles on average",
+               (double)p->totalCycles / p->numCaught);
+    }
+    printf("\n");
+
+    for (int d = 0; d < data->numDetectives; d++)
+    {
+        char *strategy = "STATIONARY";
+        for (int s = 0; s < NUM_STRATEGIES; s++)
+        {
+            if (strategies[s] == p->strategy[d])
+            {
+                strategy = strategyNames[s];
+            }
+        }
+        printf("   %s starts at [%d] %s using %s\n", data->detectives[d].name,
+               p->start[d], MapGetName(m, p->start[d]), strategy);
+    }
+}
+
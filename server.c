@@ -0,0 +1,495 @@
+// Game server
+// Reads one or more maps once and then plays games on them on request, so
+// that a pipeline playing many short games on the same map does not read
+// and build the map for every game.
+//
+// Usage: ./server [-u <socket path>] [-N] [-H] <city data file>...
+//
+// Requests are read a line at a time from stdin, or from every client that
+// connects to the Unix socket, and each request gets one line in reply:
+//   play <map> <agent data file> <cycles> [seed]
+//   game <map> <cycles> <seed> <getaway> <thief stamina> <thief start>
+//        <thief strategy> <stamina> <start> <strategy> [...]
+//   quit
+// <map> is the position of the map's city data file among the arguments,
+// starting from 0. `game` gives the agents on the request line, one or more
+// detectives as a stamina, start city and strategy each. The reply to a game
+// is "ok <result> <cycles>", where the result is caught, escaped or cold,
+// and the reply to a bad request is "error <reason>".
+//
+// The maps are never changed, so every client is served on its own thread
+// and all of them play on the same maps. With -N, every map is copied onto
+// every NUMA node, and each client's thread is pinned to a node in turn and
+// plays on that node's copies. With -H, the copies are backed by huge pages.
+
+#define _POSIX_C_SOURCE 200809L // for fdopen, getline and strtok_r
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Agent.h"
+#include "Game.h"
+#include "Loader.h"
+#include "Map.h"
+#include "Numa.h"
+#include "Pool.h"
+#include "Replicas.h"
+
+#define DEFAULT_SEED 1
+#define MAX_TOKENS 1024 // so at most about 330 detectives per game request
+#define SOCKET_BACKLOG 16
+
+struct server
+{
+    Map *maps;          // each NULL once it has been copied
+    Replicas *replicas; // or NULL if the maps are not copied
+    int numMaps;
+    int numNodes;       // that clients are spread over
+    bool pinned;        // whether clients are pinned to their nodes
+};
+
+// A client connected to the socket
+struct client
+{
+    struct server *server;
+    int fd;
+    int node;
+};
+
+// The node whose copies of the maps the current thread plays on
+static __thread int currentNode = 0;
+
+static void showUsage(char *program);
+static void copyMaps(struct server *server, bool perNode, bool hugePages);
+static int serveSocket(struct server *server, char *path);
+static void *serveClient(void *arg);
+static void serve(struct server *server, FILE *in, FILE *out);
+static bool handleRequest(struct server *server, char *line, FILE *out);
+static void play(struct server *server, char *tokens[], int numTokens,
+                 FILE *out);
+static void game(struct server *server, char *tokens[], int numTokens,
+                 FILE *out);
+static Map findMap(struct server *server, char *token);
+static void playGame(Map m, struct gameData *data, int cycles,
+                     unsigned int seed, FILE *out);
+
+int main(int argc, char *argv[])
+{
+    char *socketPath = NULL;
+    bool perNode = false;
+    bool hugePages = false;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++)
+    {
+        if (strcmp(argv[first], "-u") == 0 && first + 1 < argc)
+        {
+            socketPath = argv[++first];
+        }
+        else if (strcmp(argv[first], "-N") == 0)
+        {
+            perNode = true;
+        }
+        else if (strcmp(argv[first], "-H") == 0)
+        {
+            hugePages = true;
+        }
+        else
+        {
+            showUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (first >= argc)
+    {
+        showUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct server server;
+    server.numMaps = argc - first;
+    server.maps = malloc(server.numMaps * sizeof(Map));
+    if (server.maps == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    Pool loaders = PoolNew(PoolDefaultNumThreads());
+    for (int i = 0; i < server.numMaps; i++)
+    {
+        server.maps[i] = LoaderReadCitiesParallel(argv[first + i], loaders);
+        if (server.maps[i] == NULL)
+        {
+            fprintf(stderr, "error: couldn't read city data from '%s'\n",
+                    argv[first + i]);
+            return EXIT_FAILURE;
+        }
+    }
+    PoolFree(loaders);
+    server.replicas = NULL;
+    server.numNodes = 1;
+    server.pinned = perNode;
+    if (perNode || hugePages)
+    {
+        copyMaps(&server, perNode, hugePages);
+    }
+
+    int status = EXIT_SUCCESS;
+    if (socketPath == NULL)
+    {
+        if (server.pinned)
+        {
+            NumaPinThread(currentNode);
+        }
+        serve(&server, stdin, stdout);
+    }
+    else
+    {
+        status = serveSocket(&server, socketPath);
+    }
+
+    for (int i = 0; i < server.numMaps; i++)
+    {
+        if (server.replicas != NULL)
+        {
+            ReplicasFree(server.replicas[i]);
+        }
+        else
+        {
+            MapFree(server.maps[i]);
+        }
+    }
+    free(server.maps);
+    free(server.replicas);
+    return status;
+}
+
+/**
+ * Prints how to use the program
+ */
+static void showUsage(char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-u <socket path>] [-N] [-H] <city data file>...\n"
+            "  -u <path>    serve clients on a Unix socket instead of stdin\n"
+            "  -N           copy the maps onto every NUMA node and pin each\n"
+            "               client to a node\n"
+            "  -H           back the copies of the maps with huge pages\n",
+            program);
+}
+
+/**
+ * Replaces every map with replicas of it, and spreads clients over the
+ * replicas' nodes
+ */
+static void copyMaps(struct server *server, bool perNode, bool hugePages)
+{
+    server->replicas = malloc(server->numMaps * sizeof(Replicas));
+    if (server->replicas == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < server->numMaps; i++)
+    {
+        server->replicas[i] = ReplicasNew(server->maps[i], perNode,
+                                          hugePages);
+        MapFree(server->maps[i]);
+        server->maps[i] = NULL;
+    }
+    server->numNodes = ReplicasNumNodes(server->replicas[0]);
+}
+
+/**
+ * Listens on a Unix socket at the given path and serves every client that
+ * connects on a thread of its own. Only returns if the socket fails.
+ */
+static int serveSocket(struct server *server, char *path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "error: socket path '%s' is too long\n", path);
+        return EXIT_FAILURE;
+    }
+    strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listener == -1 ||
+        bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+        listen(listener, SOCKET_BACKLOG) == -1)
+    {
+        perror("error: couldn't listen on the socket");
+        return EXIT_FAILURE;
+    }
+
+    int nextNode = 0;
+    while (true)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if (fd == -1)
+        {
+            perror("error: couldn't accept a client");
+            close(listener);
+            return EXIT_FAILURE;
+        }
+
+        struct client *client = malloc(sizeof(struct client));
+        if (client == NULL)
+        {
+            fprintf(stderr, "error: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        *client = (struct client){server, fd, nextNode};
+        nextNode = (nextNode + 1) % server->numNodes;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serveClient, client) != 0)
+        {
+            fprintf(stderr, "error: couldn't start a thread for a client\n");
+            close(fd);
+            free(client);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
+
+/**
+ * Serves one client until it quits or disconnects
+ */
+static void *serveClient(void *arg)
+{
+    struct client *client = arg;
+    currentNode = client->node;
+    if (client->server->pinned)
+    {
+        NumaPinThread(currentNode);
+    }
+    FILE *in = fdopen(client->fd, "r");
+    FILE *out = fdopen(dup(client->fd), "w");
+    if (in != NULL && out != NULL)
+    {
+        serve(client->server, in, out);
+    }
+
+    if (in != NULL)
+    {
+        fclose(in);
+    }
+    else
+    {
+        close(client->fd);
+    }
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+    free(client);
+    return NULL;
+}
+
+/**
+ * Answers requests a line at a time until the input ends or it asks to quit
+ */
+static void serve(struct server *server, FILE *in, FILE *out)
+{
+    char *line = NULL;
+    size_t lineSize = 0;
+    while (getline(&line, &lineSize, in) != -1 &&
+           handleRequest(server, line, out))
+    {
+        fflush(out);
+    }
+    free(line);
+}
+
+/**
+ * Splits the request into words and answers it. Returns false if the
+ * request was to quit.
+ */
+static bool handleRequest(struct server *server, char *line, FILE *out)
+{
+    char *tokens[MAX_TOKENS];
+    int numTokens = 0;
+    char *saved;
+    for (char *token = strtok_r(line, " \t\r\n", &saved); token != NULL;
+         token = strtok_r(NULL, " \t\r\n", &saved))
+    {
+        if (numTokens == MAX_TOKENS)
+        {
+            fprintf(out, "error too many words in the request\n");
+            return true;
+        }
+        tokens[numTokens++] = token;
+    }
+
+    if (numTokens == 0)
+    {
+        return true; // blank lines are ignored
+    }
+    if (strcmp(tokens[0], "quit") == 0)
+    {
+        return false;
+    }
+    if (strcmp(tokens[0], "play") == 0)
+    {
+        play(server, tokens, numTokens, out);
+    }
+    else if (strcmp(tokens[0], "game") == 0)
+    {
+        game(server, tokens, numTokens, out);
+    }
+    else
+    {
+        fprintf(out, "error unknown request '%s'\n", tokens[0]);
+    }
+    return true;
+}
+
+/**
+ * Plays a game with the agents from an agent data file:
+ *   play <map> <agent data file> <cycles> [seed]
+ */
+static void play(struct server *server, char *tokens[], int numTokens,
+                 FILE *out)
+{
+    if (numTokens != 4 && numTokens != 5)
+    {
+        fprintf(out, "error usage: play <map> <agent data file> <cycles> "
+                     "[seed]\n");
+        return;
+    }
+    Map m = findMap(server, tokens[1]);
+    if (m == NULL)
+    {
+        fprintf(out, "error no map '%s'\n", tokens[1]);
+        return;
+    }
+    struct gameData data;
+    if (!LoaderReadAgents(tokens[2], &data))
+    {
+        fprintf(out, "error couldn't read agent data from '%s'\n", tokens[2]);
+        return;
+    }
+
+    int cycles = atoi(tokens[3]);
+    unsigned int seed = numTokens == 5 ? strtoul(tokens[4], NULL, 10)
+                                       : DEFAULT_SEED;
+    char *reason = LoaderCheckAgents(m, &data);
+    if (reason != NULL)
+    {
+        fprintf(out, "error %s\n", reason);
+    }
+    else if (cycles <= 0)
+    {
+        fprintf(out, "error the number of cycles must be positive\n");
+    }
+    else
+    {
+        playGame(m, &data, cycles, seed, out);
+    }
+    LoaderFreeAgents(&data);
+}
+
+/**
+ * Plays a game with the agents given in the request:
+ *   game <map> <cycles> <seed> <getaway> <thief stamina> <thief start>
+ *        <thief strategy> <stamina> <start> <strategy> [...]
+ */
+static void game(struct server *server, char *tokens[], int numTokens,
+                 FILE *out)
+{
+    if (numTokens < 11 || (numTokens - 8) % 3 != 0)
+    {
+        fprintf(out, "error usage: game <map> <cycles> <seed> <getaway> "
+                     "<thief stamina> <thief start> <thief strategy> "
+                     "<stamina> <start> <strategy> [...]\n");
+        return;
+    }
+    Map m = findMap(server, tokens[1]);
+    if (m == NULL)
+    {
+        fprintf(out, "error no map '%s'\n", tokens[1]);
+        return;
+    }
+    int cycles = atoi(tokens[2]);
+    unsigned int seed = strtoul(tokens[3], NULL, 10);
+
+    struct gameData data;
+    data.getaway = atoi(tokens[4]);
+    data.thief = (struct agentData){atoi(tokens[5]), atoi(tokens[6]),
+                                    atoi(tokens[7]), "Thief"};
+    data.numDetectives = (numTokens - 8) / 3;
+    data.detectives = malloc(data.numDetectives * sizeof(struct agentData));
+    if (data.detectives == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int d = 0; d < data.numDetectives; d++)
+    {
+        char **fields = &tokens[8 + 3 * d];
+        data.detectives[d] = (struct agentData){atoi(fields[0]),
+                                                atoi(fields[1]),
+                                                atoi(fields[2]), ""};
+        snprintf(data.detectives[d].name, sizeof(data.detectives[d].name),
+                 "D%d", d + 1);
+    }
+
+    char *reason = LoaderCheckAgents(m, &data);
+    if (reason != NULL)
+    {
+        fprintf(out, "error %s\n", reason);
+    }
+    else if (cycles <= 0)
+    {
+        fprintf(out, "error the number of cycles must be positive\n");
+    }
+    else
+    {
+        playGame(m, &data, cycles, seed, out);
+    }
+    LoaderFreeAgents(&data);
+}
+
+/**
+ * Returns the map with the given position, or NULL if there is none. If the
+ * maps have been copied, returns the copy on the current thread's node.
+ */
+static Map findMap(struct server *server, char *token)
+{
+    char *end;
+    long i = strtol(token, &end, 10);
+    if (end == token || *end != '\0' || i < 0 || i >= server->numMaps)
+    {
+        return NULL;
+    }
+    if (server->replicas != NULL)
+    {
+        return ReplicasMap(server->replicas[i], currentNode);
+    }
+    return server->maps[i];
+}
+
+/**
+ * Plays the game to the end and replies with how it finished
+ */
+static void playGame(Map m, struct gameData *data, int cycles,
+                     unsigned int seed, FILE *out)
+{
+    Game g = GameNew(m, data, cycles, seed);
+    int state = GameRun(g);
+    char *result = state == GAME_CAUGHT    ? "caught"
+                   : state == GAME_ESCAPED ? "escaped"
+                                           : "cold";
+    fprintf(out, "ok %s %d\n", result, GameCycle(g));
+    GameFree(g);
+}
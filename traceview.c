@@ -0,0 +1,219 @@
+// Indexed trace viewer
+// Prints the agents' cities and stamina at a cycle of an indexed trace (see
+// TraceReader.h) and the records from that cycle on, then counts the events
+// in the whole trace by scanning ranges of cycles in parallel.
+//
+// Usage: ./traceview <trace file> [-c <cycle>] [-n <records>] [-t <threads>]
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Pool.h"
+#include "Trace.h"
+#include "TraceReader.h"
+
+#define DEFAULT_RECORDS 20
+#define RANGES_PER_THREAD 4
+#define NUM_EVENTS (TRACE_COLD + 1)
+
+struct options
+{
+    int cycle;
+    int numRecords;
+    int numThreads;
+};
+
+// A range of cycles scanned by one task
+struct scanTask
+{
+    TraceReader r;
+    int start;
+    int end; // exclusive
+    long counts[NUM_EVENTS];
+};
+
+static char *eventNames[] = {
+    "move", "rest", "tip-off", "caught", "escaped", "cold",
+};
+
+static void showUsage(char *program);
+static bool readOptions(int argc, char *argv[], TraceReader r,
+                        struct options *options);
+static void printRecords(TraceReader r, int cycle, int numRecords);
+static void scanRange(void *arg);
+static double now(void);
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        showUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    TraceReader r = TraceReaderOpen(argv[1]);
+    if (r == NULL)
+    {
+        fprintf(stderr, "error: '%s' is not an indexed trace\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    struct options options;
+    if (!readOptions(argc, argv, r, &options))
+    {
+        showUsage(argv[0]);
+        TraceReaderFree(r);
+        return EXIT_FAILURE;
+    }
+
+    int first = TraceReaderFirstCycle(r);
+    int last = TraceReaderLastCycle(r);
+    printf("cycles %d to %d\n", first, last);
+
+    double start = now();
+    printRecords(r, options.cycle, options.numRecords);
+    printf("seek and read: %.6fs\n", now() - start);
+
+    // split the cycles into ranges of about the same length; each range
+    // is started with its own seek
+    start = now();
+    Pool pool = PoolNew(options.numThreads);
+    long numCycles = first < 0 ? 0 : (long)last - first + 1;
+    int numTasks = options.numThreads * RANGES_PER_THREAD;
+    if (numTasks > numCycles)
+    {
+        numTasks = numCycles > 0 ? numCycles : 1;
+    }
+    struct scanTask *tasks = calloc(numTasks, sizeof(struct scanTask));
+    if (tasks == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < numTasks; i++)
+    {
+        tasks[i].r = r;
+        tasks[i].start = first + numCycles * i / numTasks;
+        tasks[i].end = first + numCycles * (i + 1) / numTasks;
+        PoolSubmit(pool, scanRange, &tasks[i]);
+    }
+    PoolWait(pool);
+
+    long counts[NUM_EVENTS] = {0};
+    for (int i = 0; i < numTasks; i++)
+    {
+        for (int event = 0; event < NUM_EVENTS; event++)
+        {
+            counts[event] += tasks[i].counts[event];
+        }
+    }
+    printf("scanned in %.3fs on %d threads:", now() - start,
+           options.numThreads);
+    for (int event = 0; event < NUM_EVENTS; event++)
+    {
+        printf(" %s %ld", eventNames[event], counts[event]);
+    }
+    printf("\n");
+
+    free(tasks);
+    PoolFree(pool);
+    TraceReaderFree(r);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Prints how to use the program
+ */
+static void showUsage(char *program)
+{
+    fprintf(stderr,
+            "usage: %s <trace file> [options]\n"
+            "  -c <cycle>   cycle to start reading from (default: the "
+            "first)\n"
+            "  -n <records> number of records to print (default %d)\n"
+            "  -t <threads> number of worker threads (default: one per "
+            "processor)\n",
+            program, DEFAULT_RECORDS);
+}
+
+/**
+ * Reads the options after the trace file, returning false if any of them
+ * is invalid
+ */
+static bool readOptions(int argc, char *argv[], TraceReader r,
+                        struct options *options)
+{
+    *options = (struct options){TraceReaderFirstCycle(r), DEFAULT_RECORDS,
+                                PoolDefaultNumThreads()};
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc || strlen(argv[i]) != 2 || argv[i][0] != '-')
+        {
+            return false;
+        }
+
+        int value = atoi(argv[++i]);
+        switch (argv[i - 1][1])
+        {
+        case 'c': options->cycle = value; break;
+        case 'n': options->numRecords = value; break;
+        case 't': options->numThreads = value; break;
+        default: return false;
+        }
+    }
+
+    return options->numRecords >= 0 && options->numThreads > 0;
+}
+
+/**
+ * Prints every agent's city and stamina at the start of the cycle, followed
+ * by up to `numRecords` records from the cycle on
+ */
+static void printRecords(TraceReader r, int cycle, int numRecords)
+{
+    TraceCursor c = TraceSeek(r, cycle);
+    printf("at cycle %d:\n", cycle);
+    for (int agent = 0; agent < TraceCursorNumAgents(c); agent++)
+    {
+        printf("  agent %d in city %d with stamina %d\n", agent,
+               TraceCursorLocation(c, agent), TraceCursorStamina(c, agent));
+    }
+
+    struct traceRecord rec;
+    for (int i = 0; i < numRecords && TraceNext(c, &rec); i++)
+    {
+        printf("%d,%d,%d,%d,%d,%d,%s\n", rec.cycle, rec.agent, rec.from,
+               rec.to, rec.staminaCost, rec.stamina, eventNames[rec.event]);
+    }
+    TraceCursorFree(c);
+}
+
+/**
+ * Counts the events of the records in the task's range of cycles
+ */
+static void scanRange(void *arg)
+{
+    struct scanTask *task = arg;
+    TraceCursor c = TraceSeek(task->r, task->start);
+    struct traceRecord rec;
+    while (TraceNext(c, &rec) && rec.cycle < task->end)
+    {
+        task->counts[rec.event]++;
+    }
+    TraceCursorFree(c);
+}
+
+/**
+ * Returns the current time in seconds
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}